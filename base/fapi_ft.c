@@ -73,6 +73,7 @@ typedef struct ff_server_s
     gs_memory_t *mem;
     FT_Memory ftmemory;
     struct FT_MemoryRec_ ftmemory_rec;
+    struct ff_face_s *file_faces;   /* faces opened from font files */
 } ff_server;
 
 
@@ -87,6 +88,13 @@ typedef struct ff_face_s
     FT_UInt horz_res;
     FT_UInt vert_res;
 
+    /* The scale the above were derived from, so that asking for the
+     * same scale again doesn't reset the FreeType size (and with it
+     * any hinting state FreeType has built up for that size). */
+    bool scale_set;
+    fracint scale_matrix[4];
+    fracint scale_res[2];
+
     /* If non-null, the incremental interface object passed to FreeType. */
     FT_Incremental_InterfaceRec *ft_inc_int;
     /* If non-null, we're using a custom stream object for Freetype to read the font file */
@@ -96,6 +104,13 @@ typedef struct ff_face_s
     int font_data_len;
     bool data_owned;
     ff_server *server;
+
+    /* Faces opened from a font file are shared by all the fonts that
+     * load the same file and subfont, so the file is only parsed once. */
+    char *file_path;            /* non-null if on server->file_faces */
+    int subfont;
+    int refs;
+    struct ff_face_s *next;
 } ff_face;
 
 /* Here we define the struct FT_Incremental that is used as an opaque type
@@ -289,15 +304,61 @@ new_face(gs_fapi_server * a_server, FT_Face a_ft_face,
         face->data_owned = data_owned;
         face->ftstrm = ftstrm;
         face->server = (ff_server *) a_server;
+        face->scale_set = false;
+        face->file_path = NULL;
+        face->refs = 1;
+        face->next = NULL;
     }
     return face;
 }
 
+/* Find a face already opened from the given font file. */
+static ff_face *
+find_file_face(ff_server * s, const char *file_path, int subfont)
+{
+    ff_face *face;
+
+    for (face = s->file_faces; face != NULL; face = face->next)
+        if (face->subfont == subfont && !strcmp(face->file_path, file_path))
+            return face;
+    return NULL;
+}
+
+/* Make a face opened from a font file available to other fonts. */
+static void
+share_file_face(ff_server * s, ff_face * face, const char *file_path,
+                int subfont)
+{
+    size_t len = strlen(file_path) + 1;
+
+    /* Multiple master weights are set on the face, so can't be shared. */
+    if (FT_HAS_MULTIPLE_MASTERS(face->ft_face))
+        return;
+    face->file_path = FF_alloc(s->ftmemory, len);
+    if (face->file_path == NULL)
+        return;                 /* just don't share it */
+    memcpy(face->file_path, file_path, len);
+    face->subfont = subfont;
+    face->next = s->file_faces;
+    s->file_faces = face;
+}
+
 static void
 delete_face(gs_fapi_server * a_server, ff_face * a_face)
 {
     if (a_face) {
         ff_server *s = (ff_server *) a_server;
+
+        if (--a_face->refs > 0)
+            return;
+        if (a_face->file_path) {
+            ff_face **pprev = &s->file_faces;
+
+            while (*pprev != a_face)
+                pprev = &(*pprev)->next;
+            *pprev = a_face->next;
+            FF_free(s->ftmemory, a_face->file_path);
+        }
         if (a_face->ft_inc_int) {
             FT_Incremental a_info = a_face->ft_inc_int->object;
 
@@ -1103,6 +1164,19 @@ transform_decompose(FT_Matrix * a_transform, FT_UInt * xresp, FT_UInt * yresp,
     *a_y_scale = (FT_Fixed) (scaley * 64);
 }
 
+/* Is the face already set to this scale? */
+static bool
+face_has_scale(const ff_face * face, const gs_fapi_font_scale * a_font_scale)
+{
+    return face->scale_set &&
+        face->scale_matrix[0] == a_font_scale->matrix[0] &&
+        face->scale_matrix[1] == a_font_scale->matrix[1] &&
+        face->scale_matrix[2] == a_font_scale->matrix[2] &&
+        face->scale_matrix[3] == a_font_scale->matrix[3] &&
+        face->scale_res[0] == a_font_scale->HWResolution[0] &&
+        face->scale_res[1] == a_font_scale->HWResolution[1];
+}
+
 /*
  * Open a font and set its size.
  */
@@ -1143,6 +1217,14 @@ gs_fapi_ft_get_scaled_font(gs_fapi_server * a_server, gs_fapi_font * a_font,
         return 0;
     }
 
+    if (!face && !a_font->full_font_buf && a_font->font_file_path) {
+        face = find_file_face(s, a_font->font_file_path, a_font->subfont);
+        if (face) {
+            face->refs++;
+            a_font->server_font_data = face;
+        }
+    }
+
     /* Create the face if it doesn't already exist. */
     if (!face) {
         FT_Face ft_face = NULL;
@@ -1309,6 +1391,9 @@ gs_fapi_ft_get_scaled_font(gs_fapi_server * a_server, gs_fapi_font * a_font,
                 delete_inc_int(a_server, ft_inc_int);
                 return_error(gs_error_VMerror);
             }
+            if (ft_strm)
+                share_file_face(s, face, a_font->font_file_path,
+                                a_font->subfont);
             a_font->server_font_data = face;
         }
         else
@@ -1319,7 +1404,7 @@ gs_fapi_ft_get_scaled_font(gs_fapi_server * a_server, gs_fapi_font * a_font,
      * The matrix is scaled by the shift specified in the server, 16,
      * so we divide by 65536 when converting to a gs_matrix.
      */
-    if (face) {
+    if (face && !face_has_scale(face, a_font_scale)) {
         /* Convert the GS transform into an FT transform.
          * Ignore the translation elements because they contain very large values
          * derived from the current transformation matrix and so are of no use.
@@ -1357,7 +1442,14 @@ gs_fapi_ft_get_scaled_font(gs_fapi_server * a_server, gs_fapi_font * a_font,
          */
 
         FT_Set_Transform(face->ft_face, &face->ft_transform, NULL);
-        
+
+        face->scale_set = true;
+        for (i = 0; i < 4; i++)
+            face->scale_matrix[i] = a_font_scale->matrix[i];
+        face->scale_res[0] = a_font_scale->HWResolution[0];
+        face->scale_res[1] = a_font_scale->HWResolution[1];
+    }
+    if (face) {
         if (!a_font->is_type1) {
             for (i = 0; i < GS_FAPI_NUM_TTF_CMAP_REQ && !cmap; i++) {
                 if (a_font->ttf_cmap_req[i].platform_id > 0) {
@@ -1813,6 +1905,7 @@ gs_fapi_ft_set_mm_weight_vector(gs_fapi_server *server, gs_fapi_font *ff, float
     if (setit == true) {
         ft_error = FT_Set_MM_WeightVector(face->ft_face, length, nwv);
         if (ft_error != 0) return_error(gs_error_invalidaccess);
+        face->scale_set = false;
     }
 
     return 0;
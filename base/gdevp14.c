@@ -131,14 +131,18 @@ static void pdf14_debug_mask_stack_state(pdf14_ctx *ctx);
 #endif
 
 /* Buffer stack	data structure */
-gs_private_st_ptrs7(st_pdf14_buf, pdf14_buf, "pdf14_buf",
+gs_private_st_ptrs9(st_pdf14_buf, pdf14_buf, "pdf14_buf",
                     pdf14_buf_enum_ptrs, pdf14_buf_reloc_ptrs,
                     saved, data, backdrop, transfer_fn, mask_stack,
-                    matte, parent_color_info);
+                    matte, parent_color_info, tile_clear, smask_cache);
 
-gs_private_st_ptrs2(st_pdf14_ctx, pdf14_ctx, "pdf14_ctx",
+gs_private_st_ptrs3(st_pdf14_ctx, pdf14_ctx, "pdf14_ctx",
                     pdf14_ctx_enum_ptrs, pdf14_ctx_reloc_ptrs,
-                    stack, mask_stack);
+                    stack, mask_stack, smask_cache);
+
+gs_private_st_ptrs2(st_pdf14_smask_cache, pdf14_smask_cache_t,
+                    "pdf14_smask_cache", pdf14_smask_cache_enum_ptrs,
+                    pdf14_smask_cache_reloc_ptrs, next, data);
 
 gs_private_st_ptrs1(st_pdf14_clr, pdf14_parent_color_t, "pdf14_clr",
                     pdf14_clr_enum_ptrs, pdf14_clr_reloc_ptrs, previous);
@@ -1115,6 +1119,13 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
     result->num_spots = num_spots;
     result->deep = deep;
     result->page_group = false;
+    result->tile_clear = NULL;
+    result->tiles_x = 0;
+    result->tiles_y = 0;
+    result->tiles_todo = 0;
+    result->smask_cache = NULL;
+    result->smask_shift.x = 0;
+    result->smask_shift.y = 0;
     new_parent_color = gs_alloc_struct(memory, pdf14_parent_color_t, &st_pdf14_clr,
                                                 "pdf14_buf_new");
     if (new_parent_color == NULL) {
@@ -1178,6 +1189,7 @@ pdf14_buf_free(pdf14_buf *buf)
     gs_free_object(memory, buf->transfer_fn, "pdf14_buf_free");
     gs_free_object(memory, buf->matte, "pdf14_buf_free");
     gs_free_object(memory, buf->data, "pdf14_buf_free");
+    gs_free_object(memory, buf->tile_clear, "pdf14_buf_free");
 
     while (old_parent_color_info) {
        if (old_parent_color_info->icc_profile != NULL) {
@@ -1268,9 +1280,25 @@ pdf14_ctx_new(gs_int_rect *rect, int n_chan, bool additive, gx_device *dev, bool
     result->smask_depth = 0;
     result->smask_blend = false;
     result->deep = deep;
+    result->smask_cache = NULL;
+    result->smask_cache_size = 0;
     return result;
 }
 
+static void
+pdf14_smask_cache_free(pdf14_ctx *ctx)
+{
+    pdf14_smask_cache_t *sc, *next;
+
+    for (sc = ctx->smask_cache; sc != NULL; sc = next) {
+        next = sc->next;
+        gs_free_object(ctx->memory, sc->data, "pdf14_smask_cache_free");
+        gs_free_object(ctx->memory, sc, "pdf14_smask_cache_free");
+    }
+    ctx->smask_cache = NULL;
+    ctx->smask_cache_size = 0;
+}
+
 static	void
 pdf14_ctx_free(pdf14_ctx *ctx)
 {
@@ -1285,6 +1313,7 @@ pdf14_ctx_free(pdf14_ctx *ctx)
         next = buf->saved;
         pdf14_buf_free(buf);
     }
+    pdf14_smask_cache_free(ctx);
     gs_free_object (ctx->memory, ctx, "pdf14_ctx_free");
 }
 
@@ -1329,16 +1358,33 @@ pdf14_push_transparency_group(pdf14_ctx	*ctx, gs_int_rect *rect, bool isolated,
 {
     pdf14_buf *tos = ctx->stack;
     pdf14_buf *buf, *backdrop;
-    bool has_shape, has_tags;
+    bool has_shape, has_tags, deep;
 
     if_debug1m('v', ctx->memory,
                "[v]pdf14_push_transparency_group, idle = %d\n", idle);
+    /* Nothing drawn on top of an idle buffer can show */
+    if (tos->idle)
+        idle = true;
 
     /* We are going to use the shape in the knockout computation.  If previous
        buffer has a shape or if this is a knockout then we will have a shape here */
     has_shape = tos->has_shape || tos->knockout;
     /* If previous buffer has tags, then add tags here */
     has_tags = tos->has_tags;
+    /* On a 16 bit device, a plain isolated group starts out at 8 bits. It is
+       only taken to 16 bits (pdf14_buf_promote_deep) if something is drawn
+       into it that needs them, or when it is composed, so groups that only
+       have 8 bit content never cost the memory and bandwidth of 16 bits.
+       Anything else reads or composes into its parent at full depth. */
+    deep = ctx->deep;
+    if (deep && (idle || (isolated && !knockout && !has_shape && !has_tags)))
+        deep = false;
+    else if (deep && !tos->deep) {
+        int code = pdf14_buf_promote_deep(tos);
+
+        if (code < 0)
+            return code;
+    }
 
     /* If the group is NOT isolated we add in the alpha_g plane.  This enables
        recompositing to be performed ala art_pdf_recomposite_group_8 so that
@@ -1346,7 +1392,7 @@ pdf14_push_transparency_group(pdf14_ctx	*ctx, gs_int_rect *rect, bool isolated,
     /* Order of buffer data is color data, followed by alpha channel, followed by
        shape (if present), then alpha_g (if present), then tags (if present) */
     buf = pdf14_buf_new(rect, has_tags, !isolated, has_shape, idle, numcomps + 1,
-                        tos->num_spots, ctx->memory, ctx->deep);
+                        tos->num_spots, ctx->memory, deep);
     if (buf == NULL)
         return_error(gs_error_VMerror);
     if_debug4m('v', ctx->memory,
@@ -1376,10 +1422,16 @@ pdf14_push_transparency_group(pdf14_ctx	*ctx, gs_int_rect *rect, bool isolated,
     if (backdrop == NULL) {
         /* Note, don't clear out tags set by pdf14_buf_new == GS_UNKNOWN_TAG */
         /* Memsetting by 0, so this copes with the deep case too */
-        memset(buf->data, 0, buf->planestride * (buf->n_chan +
-                                                 (buf->has_shape ? 1 : 0) +
-                                                 (buf->has_alpha_g ? 1 : 0)));
+        /* A (large) isolated group is often only marked in a small part,
+           so leave the clearing until the tiles are first touched. Not
+           with tags: composing ORs the tag of every pixel into the
+           backdrop, so untouched tiles can't be skipped. */
+        if (buf->knockout || buf->has_tags || !pdf14_buf_make_lazy(buf))
+            memset(buf->data, 0, buf->planestride * (buf->n_chan +
+                                                     (buf->has_shape ? 1 : 0) +
+                                                     (buf->has_alpha_g ? 1 : 0)));
     } else {
+        pdf14_buf_touch_all(tos);
         if (!buf->knockout) {
             if (!cm_back_drop) {
                 pdf14_preserve_backdrop(buf, tos, false
@@ -1437,6 +1489,7 @@ pdf14_push_transparency_group(pdf14_ctx	*ctx, gs_int_rect *rect, bool isolated,
                     prev_knockout_profile  = child->parent_color_info->icc_profile;
                 }
             }
+            pdf14_buf_touch_all(check);
             if (!cm_back_drop) {
                 pdf14_preserve_backdrop(buf, check, false
 #if RAW_DUMP
@@ -1476,6 +1529,49 @@ pdf14_push_transparency_group(pdf14_ctx	*ctx, gs_int_rect *rect, bool isolated,
     return 0;
 }
 
+/* Compose a group that is still being cleared lazily. Tiles that have never
+   been touched are fully transparent, so leave nos unchanged; only runs of
+   touched tiles need composing. That is not so for a knockout nos, where a
+   transparent tos still knocks out to the backdrop. */
+static void
+pdf14_compose_group_tiles(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
+              int x0, int x1, int y0, int y1, int n_chan, bool additive,
+              const pdf14_nonseparable_blending_procs_t * pblend_procs,
+              bool has_matte, bool overprint, gx_color_index drawn_comps,
+              gs_memory_t *memory, gx_device *dev)
+{
+    int ty, tx, tx0, tx1, run;
+
+    if (tos->tile_clear == NULL || nos->knockout) {
+        pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, n_chan,
+                            additive, pblend_procs, has_matte, overprint,
+                            drawn_comps, memory, dev);
+        return;
+    }
+    tx0 = (x0 - tos->rect.p.x) / PDF14_TILE_SIZE;
+    tx1 = (x1 - 1 - tos->rect.p.x) / PDF14_TILE_SIZE;
+    for (ty = (y0 - tos->rect.p.y) / PDF14_TILE_SIZE;
+         ty <= (y1 - 1 - tos->rect.p.y) / PDF14_TILE_SIZE; ty++) {
+        const byte *flags = tos->tile_clear + ty * tos->tiles_x;
+        int ry0 = max(y0, tos->rect.p.y + ty * PDF14_TILE_SIZE);
+        int ry1 = min(y1, tos->rect.p.y + (ty + 1) * PDF14_TILE_SIZE);
+
+        for (tx = tx0; tx <= tx1; tx = run) {
+            if (!flags[tx]) {
+                run = tx + 1;
+                continue;
+            }
+            for (run = tx + 1; run <= tx1 && flags[run]; run++)
+                ;
+            pdf14_compose_group(tos, nos, maskbuf,
+                                max(x0, tos->rect.p.x + tx * PDF14_TILE_SIZE),
+                                min(x1, tos->rect.p.x + run * PDF14_TILE_SIZE),
+                                ry0, ry1, n_chan, additive, pblend_procs,
+                                has_matte, overprint, drawn_comps, memory, dev);
+        }
+    }
+}
+
 static	int
 pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     const pdf14_nonseparable_blending_procs_t * pblend_procs,
@@ -1492,6 +1588,7 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     bool overprint = pdev->overprint;
     gx_color_index drawn_comps = pdev->drawn_comps;
     bool has_matte = false;
+    bool convert;
 
     if (nos == NULL)
         return_error(gs_error_unknownerror);  /* Unmatched group pop */
@@ -1567,12 +1664,30 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     }
     /* If the color spaces are different and we actually did do a swap of
        the procs for color */
-    if ((nos->parent_color_info->parent_color_mapping_procs != NULL &&
-        nos_num_color_comp != tos_num_color_comp) || icc_match) {
+    convert = (nos->parent_color_info->parent_color_mapping_procs != NULL &&
+               nos_num_color_comp != tos_num_color_comp) || icc_match;
+    /* An 8 bit group (see pdf14_push_transparency_group) only holds opaque
+       or clear pixels, so just replaces the backdrop if it is put down
+       without a mask, conversion, opacity or blending, and that can be done
+       straight into an 8 or 16 bit backdrop. Any other way needs both
+       buffers at 16 bits to come out the same. */
+    if (ctx->deep && (tos->deep ? !nos->deep :
+        (convert || maskbuf != NULL || overprint || tos->alpha != 65535 ||
+         tos->blend_mode != BLEND_MODE_Normal || nos->knockout ||
+         nos->has_shape || nos->has_alpha_g || nos->has_tags))) {
+        int code = pdf14_buf_promote_deep(tos);
+
+        if (code >= 0)
+            code = pdf14_buf_promote_deep(nos);
+        if (code < 0)
+            return code;
+    }
+    if (convert) {
         if (x0 < x1 && y0 < y1) {
             pdf14_buf *result;
             bool did_alloc; /* We don't care here */
 
+            pdf14_buf_touch_all(tos);
             if (has_matte) {
                 result = pdf14_transform_color_buffer_with_matte(pgs, ctx, dev,
                     tos, tos->data, curr_icc_profile, nos->parent_color_info->icc_profile,
@@ -1606,9 +1721,10 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     } else {
         /* Group color spaces are the same.  No color conversions needed */
         if (x0 < x1 && y0 < y1)
-            pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
-                                ctx->additive, pblend_procs, has_matte, overprint,
-                                drawn_comps, ctx->memory, dev);
+            pdf14_compose_group_tiles(tos, nos, maskbuf, x0, x1, y0, y1,
+                                      nos->n_chan, ctx->additive, pblend_procs,
+                                      has_matte, overprint, drawn_comps,
+                                      ctx->memory, dev);
     }
 exit:
     ctx->stack = nos;
@@ -1646,6 +1762,8 @@ pdf14_push_transparency_mask(pdf14_ctx *ctx, gs_int_rect *rect,	uint16_t bg_alph
     if_debug2m('v', ctx->memory,
                "[v]pdf14_push_transparency_mask, idle=%d, replacing=%d\n",
                idle, replacing);
+    if (ctx->stack->idle)
+        idle = true;
     ctx->smask_depth += 1;
 
     /* An optimization to consider is that if the SubType is Alpha
@@ -1754,6 +1872,217 @@ static void pdf14_free_mask_stack(pdf14_ctx *ctx, gs_memory_t *memory)
     ctx->mask_stack = NULL;
 }
 
+/* Make a popped soft mask the current one */
+static int
+pdf14_set_mask_buf(pdf14_ctx *ctx, pdf14_buf *tos)
+{
+    /* Assign as reference counted mask buffer */
+    if (ctx->mask_stack != NULL) {
+        /* In this case, the source file is wacky as it already had a
+           softmask and now is getting a replacement. We need to clean
+           up the softmask stack before doing this free and creating
+           a new stack. Bug 693312 */
+        pdf14_free_mask_stack(ctx, ctx->memory);
+    }
+    ctx->mask_stack = pdf14_mask_element_new(ctx->memory);
+    if (ctx->mask_stack == NULL)
+        return gs_note_error(gs_error_VMerror);
+    ctx->mask_stack->rc_mask = pdf14_rcmask_new(ctx->memory);
+    if (ctx->mask_stack->rc_mask == NULL)
+        return gs_note_error(gs_error_VMerror);
+    ctx->mask_stack->rc_mask->mask_buf = tos;
+    return 0;
+}
+
+/* Bytes of finished soft masks that a context keeps for reuse */
+#define PDF14_SMASK_CACHE_SIZE (16 * 1024 * 1024)
+
+/* Look for a finished mask that a new one (group_rect, clipped to rect) can
+   be copied from, which needs everything that goes into drawing it to be
+   the same, bar a whole pixel translation. A clip that cuts into the mask
+   stays where it is, so it rules out any translation. */
+static pdf14_smask_cache_t *
+pdf14_smask_cache_find(pdf14_ctx *ctx, const gx_transparency_mask_params_t *ptmp,
+                       gs_transparency_color_t group_color, int64_t icc_hashcode,
+                       const gs_matrix *ctm, const gs_rect *pbbox,
+                       const gs_int_rect *group_rect, const gs_int_rect *rect,
+                       gs_int_point *shift)
+{
+    pdf14_smask_cache_t *sc;
+    int i, dx, dy;
+
+    for (sc = ctx->smask_cache; sc != NULL; sc = sc->next) {
+        if (sc->data == NULL || sc->cache_id != ptmp->cache_id ||
+            sc->clip_id != ptmp->cache_clip_id ||
+            sc->state != ptmp->cache_state ||
+            sc->group_color != group_color ||
+            sc->icc_hashcode != icc_hashcode ||
+            sc->subtype != ptmp->subtype ||
+            sc->ctm.xx != ctm->xx || sc->ctm.xy != ctm->xy ||
+            sc->ctm.yx != ctm->yx || sc->ctm.yy != ctm->yy ||
+            sc->bbox.p.x != pbbox->p.x || sc->bbox.p.y != pbbox->p.y ||
+            sc->bbox.q.x != pbbox->q.x || sc->bbox.q.y != pbbox->q.y ||
+            sc->GrayBackground != ptmp->GrayBackground ||
+            sc->Background_components != ptmp->Background_components)
+            continue;
+        for (i = 0; i < sc->Background_components; i++)
+            if (sc->Background[i] != ptmp->Background[i])
+                break;
+        if (i < sc->Background_components)
+            continue;
+        dx = group_rect->p.x - sc->group_rect.p.x;
+        dy = group_rect->p.y - sc->group_rect.p.y;
+        if ((double)ctm->tx - sc->ctm.tx != dx ||
+            (double)ctm->ty - sc->ctm.ty != dy ||
+            group_rect->q.x - dx != sc->group_rect.q.x ||
+            group_rect->q.y - dy != sc->group_rect.q.y)
+            continue;
+        if (sc->clip_id != 0 && (dx != 0 || dy != 0))
+            continue;
+        if (rect->p.x - dx < sc->rect.p.x || rect->q.x - dx > sc->rect.q.x ||
+            rect->p.y - dy < sc->rect.p.y || rect->q.y - dy > sc->rect.q.y)
+            continue;
+        shift->x = dx;
+        shift->y = dy;
+        return sc;
+    }
+    return NULL;
+}
+
+/* Start a cache entry for a mask that is about to be drawn */
+static pdf14_smask_cache_t *
+pdf14_smask_cache_new(pdf14_ctx *ctx, const gx_transparency_mask_params_t *ptmp,
+                      gs_transparency_color_t group_color, int64_t icc_hashcode,
+                      const gs_matrix *ctm, const gs_rect *pbbox,
+                      const gs_int_rect *group_rect)
+{
+    pdf14_smask_cache_t *sc;
+
+    sc = gs_alloc_struct(ctx->memory, pdf14_smask_cache_t,
+                         &st_pdf14_smask_cache, "pdf14_smask_cache_new");
+    if (sc == NULL)
+        return NULL;
+    sc->cache_id = ptmp->cache_id;
+    sc->clip_id = ptmp->cache_clip_id;
+    sc->state = ptmp->cache_state;
+    sc->group_color = group_color;
+    sc->icc_hashcode = icc_hashcode;
+    sc->subtype = ptmp->subtype;
+    sc->ctm = *ctm;
+    sc->bbox = *pbbox;
+    sc->group_rect = *group_rect;
+    sc->Background_components = ptmp->Background_components;
+    memcpy(sc->Background, ptmp->Background,
+           sizeof(sc->Background[0]) * ptmp->Background_components);
+    sc->GrayBackground = ptmp->GrayBackground;
+    sc->rowstride = 0;
+    sc->size = 0;
+    sc->data = NULL;
+    sc->next = ctx->smask_cache;
+    ctx->smask_cache = sc;
+    return sc;
+}
+
+static void
+pdf14_smask_cache_unlink(pdf14_ctx *ctx, pdf14_smask_cache_t *sc)
+{
+    pdf14_smask_cache_t **psc;
+
+    for (psc = &ctx->smask_cache; *psc != NULL; psc = &(*psc)->next)
+        if (*psc == sc) {
+            *psc = sc->next;
+            return;
+        }
+}
+
+/* Keep a copy of the mask that has just been finished in tos, dropping the
+   least recently used masks to make room. */
+static void
+pdf14_smask_cache_store(pdf14_ctx *ctx, pdf14_buf *tos)
+{
+    pdf14_smask_cache_t *sc = tos->smask_cache;
+    pdf14_smask_cache_t **psc, **pold;
+
+    tos->smask_cache = NULL;
+    pdf14_smask_cache_unlink(ctx, sc);
+    if (tos->planestride <= PDF14_SMASK_CACHE_SIZE)
+        sc->data = gs_alloc_bytes(ctx->memory, tos->planestride,
+                                  "pdf14_smask_cache_store");
+    if (sc->data == NULL) {
+        gs_free_object(ctx->memory, sc, "pdf14_smask_cache_store");
+        return;
+    }
+    memcpy(sc->data, tos->data, tos->planestride);
+    sc->rect = tos->rect;
+    sc->rowstride = tos->rowstride;
+    sc->size = tos->planestride;
+    while (ctx->smask_cache_size + sc->size > PDF14_SMASK_CACHE_SIZE) {
+        pdf14_smask_cache_t *old;
+
+        /* Masks still being drawn have no data, and are left alone */
+        pold = NULL;
+        for (psc = &ctx->smask_cache; *psc != NULL; psc = &(*psc)->next)
+            if ((*psc)->data != NULL)
+                pold = psc;
+        if (pold == NULL)
+            break;
+        old = *pold;
+        *pold = old->next;
+        ctx->smask_cache_size -= old->size;
+        gs_free_object(ctx->memory, old->data, "pdf14_smask_cache_store");
+        gs_free_object(ctx->memory, old, "pdf14_smask_cache_store");
+    }
+    ctx->smask_cache_size += sc->size;
+    sc->next = ctx->smask_cache;
+    ctx->smask_cache = sc;
+}
+
+/* Fill in a mask that was pushed empty, and not drawn, because it could be
+   copied from the cache. */
+static int
+pdf14_smask_cache_copy(pdf14_ctx *ctx, pdf14_buf *tos)
+{
+    pdf14_smask_cache_t *sc = tos->smask_cache;
+    int dx = tos->smask_shift.x;
+    int dy = tos->smask_shift.y;
+    gs_int_rect rect;
+    int width, height, rowstride, y;
+    byte *data;
+
+    rect.p.x = sc->group_rect.p.x + dx;
+    rect.p.y = sc->group_rect.p.y + dy;
+    rect.q.x = sc->group_rect.q.x + dx;
+    rect.q.y = sc->group_rect.q.y + dy;
+    rect_intersect(rect, ctx->rect);
+    width = rect.q.x - rect.p.x;
+    height = rect.q.y - rect.p.y;
+    rowstride = ((width + 3) & -4) << tos->deep;
+    data = gs_alloc_bytes(ctx->memory, rowstride * height,
+                          "pdf14_smask_cache_copy");
+    if (data == NULL)
+        return_error(gs_error_VMerror);
+    memset(data, 0, rowstride * height);
+    for (y = 0; y < height; y++)
+        memcpy(data + y * rowstride,
+               sc->data + (rect.p.y + y - dy - sc->rect.p.y) * sc->rowstride +
+               ((rect.p.x - dx - sc->rect.p.x) << tos->deep),
+               width << tos->deep);
+    gs_free_object(ctx->memory, tos->data, "pdf14_smask_cache_copy");
+    tos->data = data;
+    tos->rect = rect;
+    tos->rowstride = rowstride;
+    tos->planestride = rowstride * height;
+    tos->n_chan = 1;
+    tos->n_planes = 1;
+    tos->idle = false;
+    tos->smask_cache = NULL;
+    /* Most recently used first */
+    pdf14_smask_cache_unlink(ctx, sc);
+    sc->next = ctx->smask_cache;
+    ctx->smask_cache = sc;
+    return 0;
+}
+
 static	int
 pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
 {
@@ -1800,6 +2129,15 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
         }
         tos->mask_stack = NULL;
     }
+    if (tos->smask_cache != NULL && tos->smask_cache->data != NULL) {
+        int code = pdf14_smask_cache_copy(ctx, tos);
+
+        if (code < 0)
+            return code;
+        if (tos->SMask_SubType == TRANSPARENCY_MASK_Alpha)
+            ctx->smask_blend = false;
+        return pdf14_set_mask_buf(ctx, tos);
+    }
     if (tos->data == NULL ) {
         /* This can occur in clist rendering if the soft mask does
            not intersect the current band.  It would be nice to
@@ -1930,21 +2268,9 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
         /* Data is single channel now */
         tos->n_chan = 1;
         tos->n_planes = 1;
-        /* Assign as reference counted mask buffer */
-        if (ctx->mask_stack != NULL) {
-            /* In this case, the source file is wacky as it already had a
-               softmask and now is getting a replacement. We need to clean
-               up the softmask stack before doing this free and creating
-               a new stack. Bug 693312 */
-            pdf14_free_mask_stack(ctx, ctx->memory);
-        }
-        ctx->mask_stack = pdf14_mask_element_new(ctx->memory);
-        if (ctx->mask_stack == NULL)
-            return gs_note_error(gs_error_VMerror);
-        ctx->mask_stack->rc_mask = pdf14_rcmask_new(ctx->memory);
-        if (ctx->mask_stack->rc_mask == NULL)
-            return gs_note_error(gs_error_VMerror);
-        ctx->mask_stack->rc_mask->mask_buf = tos;
+        if (tos->smask_cache != NULL)
+            pdf14_smask_cache_store(ctx, tos);
+        return pdf14_set_mask_buf(ctx, tos);
     }
     return 0;
 }
@@ -2032,6 +2358,8 @@ pdf14_open(gx_device *dev)
 {
     pdf14_device *pdev = (pdf14_device *)dev;
     gs_int_rect rect;
+    bool restricted = pdev->page_rect.p.x < pdev->page_rect.q.x &&
+                      pdev->page_rect.p.y < pdev->page_rect.q.y;
 
     if_debug2m('v', dev->memory, "[v]pdf14_open: width = %d, height = %d\n",
                dev->width, dev->height);
@@ -2039,6 +2367,10 @@ pdf14_open(gx_device *dev)
     rect.p.y = 0;
     rect.q.x = dev->width;
     rect.q.y = dev->height;
+    /* The clist reader may have already rendered the band without us, in
+       which case we only composite the part of it that has transparency. */
+    if (restricted)
+        rect_intersect(rect, pdev->page_rect);
     /* If we are reenabling the device dont create a new ctx. Bug 697456 */
     if (pdev->ctx == NULL) {
         bool has_tags = device_encodes_tags(dev);
@@ -2047,6 +2379,9 @@ pdf14_open(gx_device *dev)
         pdev->ctx = pdf14_ctx_new(&rect, dev->color_info.num_components,
             pdev->color_info.polarity != GX_CINFO_POLARITY_SUBTRACTIVE, dev,
             bits_per_comp > 8);
+        /* Everything in that part was drawn over, so all of it gets put back */
+        if (pdev->ctx != NULL && restricted)
+            pdev->ctx->stack->dirty = rect;
     }
     if (pdev->ctx == NULL)
         return_error(gs_error_VMerror);
@@ -2118,6 +2453,14 @@ pdf14_get_buffer_information(const gx_device * dev,
     pdf14_debug_mask_stack_state(pdev->ctx);
 #endif
     buf = pdev->ctx->stack;
+    pdf14_buf_touch_all(buf);
+    /* The pattern code works at the depth of the device */
+    if (pdev->ctx->deep) {
+        int code = pdf14_buf_promote_deep(buf);
+
+        if (code < 0)
+            return code;
+    }
     rect = buf->rect;
     transbuff->buf = (free_device ? NULL : buf);
     x1 = min(pdev->width, rect.q.x);
@@ -2305,7 +2648,9 @@ pdf14_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
 #endif
     if (width <= 0 || height <= 0 || buf->data == NULL)
         return 0;
-    buf_ptr = buf->data + rect.p.y * rowstride + (rect.p.x<<deep);
+    pdf14_buf_touch_all(buf);
+    buf_ptr = buf->data + (rect.p.y - buf->rect.p.y) * rowstride +
+              ((rect.p.x - buf->rect.p.x)<<deep);
 
     /* Check that target is OK.  From fuzzing results the target could have been
        destroyed, for e.g if it were a pattern accumulator that was closed
@@ -2613,7 +2958,9 @@ pdf14_cmykspot_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     height = y1 - rect.p.y;
     if (width <= 0 || height <= 0 || buf->data == NULL)
         return 0;
-    buf_ptr = buf->data + rect.p.y * buf->rowstride + (rect.p.x<<deep);
+    pdf14_buf_touch_all(buf);
+    buf_ptr = buf->data + (rect.p.y - buf->rect.p.y) * buf->rowstride +
+              ((rect.p.x - buf->rect.p.x)<<deep);
 #if RAW_DUMP
     /* Dump the current buffer to see what we have. */
     dump_raw_buffer(pdev->ctx->memory,
@@ -2650,7 +2997,6 @@ pdf14_custom_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     pdf14_buf *buf = pdev->ctx->stack;
     bool deep = pdev->ctx->deep;
     gs_int_rect rect = buf->rect;
-    int x0 = rect.p.x, y0 = rect.p.y;
     int planestride = buf->planestride;
     int rowstride = buf->rowstride;
     int num_comp = buf->n_chan - 1;
@@ -2671,11 +3017,13 @@ pdf14_custom_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     height = y1 - rect.p.y;
     if (width <= 0 || height <= 0 || buf->data == NULL)
         return 0;
-    buf_ptr = buf->data + rect.p.y * buf->rowstride + (rect.p.x<<deep);
+    pdf14_buf_touch_all(buf);
+    buf_ptr = buf->data + (rect.p.y - buf->rect.p.y) * buf->rowstride +
+              ((rect.p.x - buf->rect.p.x)<<deep);
 
     return gx_put_blended_image_custom(target, buf_ptr,
                       planestride, rowstride,
-                      x0, y0, width, height, num_comp, bg, deep);
+                      rect.p.x, rect.p.y, width, height, num_comp, bg, deep);
 }
 
 /* This is rather nasty: in the event we are interrupted (by an error) between a push and pop
@@ -2770,6 +3118,7 @@ pdf14_discard_trans_layer(gx_device *dev, gs_gstate * pgs)
             gs_free_object(ctx->memory, buf->transfer_fn, "pdf14_discard_trans_layer");
             gs_free_object(ctx->memory, buf->matte, "pdf14_discard_trans_layer");
             gs_free_object(ctx->memory, buf->data, "pdf14_discard_trans_layer");
+            gs_free_object(ctx->memory, buf->tile_clear, "pdf14_discard_trans_layer");
             gs_free_object(ctx->memory, buf->backdrop, "pdf14_discard_trans_layer");
             /* During the soft mask push, the mask_stack was copied (not moved) from
                the ctx to the tos mask_stack. We are done with this now so it is safe
@@ -2781,6 +3130,7 @@ pdf14_discard_trans_layer(gx_device *dev, gs_gstate * pgs)
             }
             gs_free_object(ctx->memory, buf, "pdf14_discard_trans_layer");
         }
+        pdf14_smask_cache_free(ctx);
         /* Finally the context itself */
         gs_free_object (ctx->memory, ctx, "pdf14_discard_trans_layer");
         pdev->ctx = NULL;
@@ -3338,6 +3688,7 @@ do_pdf14_copy_alpha_color(gx_device * dev, const byte * data, int data_x,
     }
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    pdf14_buf_touch(buf, x, y, x + w, y + h);
     /* Update the dirty rectangle. */
     if (x < buf->dirty.p.x) buf->dirty.p.x = x;
     if (y < buf->dirty.p.y) buf->dirty.p.y = y;
@@ -3524,6 +3875,7 @@ do_pdf14_copy_alpha_color_16(gx_device * dev, const byte * data, int data_x,
     }
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    pdf14_buf_touch(buf, x, y, x + w, y + h);
     /* Update the dirty rectangle. */
     if (x < buf->dirty.p.x) buf->dirty.p.x = x;
     if (y < buf->dirty.p.y) buf->dirty.p.y = y;
@@ -3644,13 +3996,19 @@ pdf14_copy_alpha_color(gx_device * dev, const byte * data, int data_x,
                       gx_color_index color, const gx_device_color *pdc,
                       int depth, bool devn)
 {
+    pdf14_device *pdev = (pdf14_device *)dev;
     bool deep = device_is_deep(dev);
 
-    if (deep)
+    if (deep) {
+        /* Anti-aliased marks need the group at full depth */
+        int code = pdf14_buf_promote_deep(pdev->ctx->stack);
+
+        if (code < 0)
+            return code;
         return do_pdf14_copy_alpha_color_16(dev, data, data_x, aa_raster,
                                             id, x, y, w, h,
                                             color, pdc, depth, devn);
-    else
+    } else
         return do_pdf14_copy_alpha_color(dev, data, data_x, aa_raster,
                                          id, x, y, w, h,
                                          color, pdc, depth, devn);
@@ -4946,6 +5304,18 @@ pdf14_copy_mono(gx_device * dev,
     return 0;
 }
 
+/* True if a mark lies wholly outside the area the context composites. This
+   is the whole device unless the clist reader restricted it (see pdf14_open),
+   so only then does it let us skip marks without the cost of blending setup. */
+static inline bool
+pdf14_outside_ctx(const pdf14_device *pdev, int x, int y, int w, int h)
+{
+    const gs_int_rect *rect = &pdev->ctx->rect;
+
+    return x >= rect->q.x || y >= rect->q.y ||
+           x + w <= rect->p.x || y + h <= rect->p.y;
+}
+
 /* Used in a few odd cases where the target device is planar and we have
    a planar tile (pattern) and we are copying it into place here */
 
@@ -4963,7 +5333,26 @@ pdf14_copy_planes(gx_device * dev, const byte * data, int data_x, int raster,
     pdf14_buf fake_tos;
     int deep = pdev->ctx->deep;
 
+    if (deep) {
+        int code = pdf14_buf_promote_deep(buf);
+
+        if (code < 0)
+            return code;
+    }
     fit_fill_xywh(dev, x, y, w, h);
+    /* The buffer may not cover the whole device (see pdf14_open) */
+    if (x < buf->rect.p.x) {
+        w -= buf->rect.p.x - x;
+        x = buf->rect.p.x;
+    }
+    if (y < buf->rect.p.y) {
+        h -= buf->rect.p.y - y;
+        y = buf->rect.p.y;
+    }
+    if (x + w > buf->rect.q.x)
+        w = buf->rect.q.x - x;
+    if (y + h > buf->rect.q.y)
+        h = buf->rect.q.y - y;
     if (w <= 0 || h <= 0)
         return 0;
 
@@ -4972,7 +5361,7 @@ pdf14_copy_planes(gx_device * dev, const byte * data, int data_x, int raster,
     fake_tos.backdrop = NULL;
     fake_tos.blend_mode = pdev->blend_mode;
     fake_tos.color_space = buf->color_space;
-    fake_tos.data = (byte *)data + ((data_x - (x - xo))<<deep) - (y - yo) * raster; /* Nasty, cast away of const */
+    fake_tos.data = (byte *)data + ((data_x + (x - xo))<<deep) + (y - yo) * raster; /* Nasty, cast away of const */
     fake_tos.dirty.p.x = x;
     fake_tos.dirty.p.y = y;
     fake_tos.dirty.q.x = x + w;
@@ -4999,6 +5388,7 @@ pdf14_copy_planes(gx_device * dev, const byte * data, int data_x, int raster,
     fake_tos.rect.q.y = y + h;
     fake_tos.rowstride = raster;
     fake_tos.saved = NULL;
+    fake_tos.tile_clear = NULL;
     fake_tos.shape = 0xffff;
     fake_tos.SMask_SubType = TRANSPARENCY_MASK_Alpha;
     fake_tos.transfer_fn = NULL;
@@ -5022,6 +5412,8 @@ pdf14_fill_rectangle_hl_color(gx_device *dev, const gs_fixed_rect *rect,
     fit_fill_xywh(dev, x, y, w, h);
     if (w <= 0 || h <= 0)
         return 0;
+    if (pdf14_outside_ctx(pdev, x, y, w, h))
+        return 0;
     if (buf->knockout)
         return pdf14_mark_fill_rectangle_ko_simple(dev, x, y, w, h, 0, pdcolor,
                                                    true);
@@ -5039,6 +5431,8 @@ pdf14_fill_rectangle(gx_device * dev,
     fit_fill_xywh(dev, x, y, w, h);
     if (w <= 0 || h <= 0)
         return 0;
+    if (pdf14_outside_ctx(pdev, x, y, w, h))
+        return 0;
     if (buf->knockout)
         return pdf14_mark_fill_rectangle_ko_simple(dev, x, y, w, h, color, NULL,
                                                    false);
@@ -5848,6 +6242,11 @@ pdf14_begin_transparency_mask(gx_device	*dev,
     int group_color_numcomps;
     gs_transparency_color_t group_color;
     bool deep = device_is_deep(dev);
+    bool cache = false;
+    pdf14_smask_cache_t *sc = NULL;
+    gs_int_rect group_rect;
+    gs_int_point shift;
+    int64_t icc_hashcode = 0;
 
     if (ptmp->subtype == TRANSPARENCY_MASK_None) {
         pdf14_ctx *ctx = pdev->ctx;
@@ -5910,11 +6309,49 @@ pdf14_begin_transparency_mask(gx_device	*dev,
                                            pgs, ptmp->iccprofile, true);
     if (code < 0)
         return code;
+    /* A mask that the interpreter has named may be in the cache, in which
+       case it is pushed empty, so that nothing is drawn in it, and filled
+       in from the cache when it is popped. The mask is stored converted to
+       gray, so the space it was blended in, now set up as the device
+       profile, is part of the key. */
+    if (ptmp->cache_id != 0 && !ptmp->idle && ptmp->Matte_components == 0 &&
+        !pdev->ctx->stack->idle && rect.q.x > rect.p.x && rect.q.y > rect.p.y) {
+        cmm_dev_profile_t *dev_profile;
+        cmm_profile_t *blend_profile = NULL;
+        gsicc_rendering_param_t render_cond;
+
+        code = dev_proc(dev, get_profile)(dev, &dev_profile);
+        if (code < 0) {
+            gs_free_object(pdev->ctx->memory, transfer_fn,
+                           "pdf14_begin_transparency_mask");
+            return code;
+        }
+        if (dev_profile != NULL)
+            gsicc_extract_profile(GS_UNKNOWN_TAG, dev_profile, &blend_profile,
+                                  &render_cond);
+        if (blend_profile != NULL &&
+            (blend_profile->hash_is_valid || blend_profile->buffer != NULL)) {
+            code = pdf14_compute_group_device_int_rect(&ctm_only(pgs), pbbox,
+                                                       &group_rect);
+            if (code < 0) {
+                gs_free_object(pdev->ctx->memory, transfer_fn,
+                               "pdf14_begin_transparency_mask");
+                return code;
+            }
+            cache = true;
+            icc_hashcode = gsicc_get_hash(blend_profile);
+            sc = pdf14_smask_cache_find(pdev->ctx, ptmp, group_color,
+                                        icc_hashcode, &ctm_only(pgs), pbbox,
+                                        &group_rect, &rect, &shift);
+            if (sc != NULL)
+                rect.q = rect.p;
+        }
+    }
     /* Note that the soft mask always follows the group color requirements even
        when we have a separable device */
-    return pdf14_push_transparency_mask(pdev->ctx, &rect, bg_alpha,
+    code = pdf14_push_transparency_mask(pdev->ctx, &rect, bg_alpha,
                                         transfer_fn, ptmp->function_is_identity,
-                                        ptmp->idle, ptmp->replacing,
+                                        ptmp->idle || sc != NULL, ptmp->replacing,
                                         ptmp->mask_id, ptmp->subtype,
                                         group_color_numcomps,
                                         ptmp->Background_components,
@@ -5922,6 +6359,16 @@ pdf14_begin_transparency_mask(gx_device	*dev,
                                         ptmp->Matte_components,
                                         ptmp->Matte,
                                         ptmp->GrayBackground);
+    if (code < 0 || !cache)
+        return code;
+    if (sc != NULL) {
+        pdev->ctx->stack->smask_cache = sc;
+        pdev->ctx->stack->smask_shift = shift;
+    } else if (pdev->ctx->stack->data != NULL)
+        pdev->ctx->stack->smask_cache =
+            pdf14_smask_cache_new(pdev->ctx, ptmp, group_color, icc_hashcode,
+                                  &ctm_only(pgs), pbbox, &group_rect);
+    return 0;
 }
 
 static	int
@@ -6069,6 +6516,7 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
     }
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    pdf14_buf_touch(buf, x, y, x + w, y + h);
     /* Update the dirty rectangle with the mark. */
     if (x < buf->dirty.p.x) buf->dirty.p.x = x;
     if (y < buf->dirty.p.y) buf->dirty.p.y = y;
@@ -6244,6 +6692,7 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
     }
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    pdf14_buf_touch(buf, x, y, x + w, y + h);
     /* Update the dirty rectangle with the mark. */
     if (x < buf->dirty.p.x) buf->dirty.p.x = x;
     if (y < buf->dirty.p.y) buf->dirty.p.y = y;
@@ -6753,6 +7202,12 @@ pdf14_dev_spec_op(gx_device *pdev, int dev_spec_op,
     }
     if (dev_spec_op == gxdso_is_encoding_direct)
         return 1;
+    if (dev_spec_op == gxdso_pdf14_smask_cached) {
+        pdf14_buf *tos = p14dev->ctx == NULL ? NULL : p14dev->ctx->stack;
+
+        return tos != NULL && tos->smask_cache != NULL &&
+               tos->smask_cache->data != NULL;
+    }
 
     /* We don't want to pass on these spec_ops either, because the child might respond
      * with an inappropriate response when the PDF14 device is active. For example; the
@@ -6854,6 +7309,8 @@ gs_pdf14_device_push(gs_memory_t *mem, gs_gstate * pgs,
     p14dev->pad = target->pad;
     p14dev->log2_align_mod = target->log2_align_mod;
     p14dev->is_planar = target->is_planar;
+    if (!use_pdf14_accum)
+        p14dev->page_rect = pdf14pct->params.page_rect;
     /* If the target profile was CIELAB (and we are not using a blend CS),
        then overide with default RGB for
        proper blending.  During put_image we will convert from RGB to
@@ -7189,6 +7646,9 @@ c_pdf14trans_write(const gs_composite_t	* pct, byte * data, uint * psize,
             put_value(pbuf, pparams->bbox);
             mask_id = pparams->mask_id;
             put_value(pbuf, mask_id);
+            put_value(pbuf, pparams->cache_id);
+            put_value(pbuf, pparams->cache_clip_id);
+            put_value(pbuf, pparams->cache_state);
             if (pparams->Background_components) {
                 const int l = sizeof(pparams->Background[0]) * pparams->Background_components;
 
@@ -7392,6 +7852,9 @@ c_pdf14trans_read(gs_composite_t * * ppct, const byte *	data,
             params.Matte_components = *data++;
             read_value(data, params.bbox);
             read_value(data, params.mask_id);
+            read_value(data, params.cache_id);
+            read_value(data, params.cache_clip_id);
+            read_value(data, params.cache_state);
             if (params.Background_components) {
                 const int l = sizeof(params.Background[0]) * params.Background_components;
 
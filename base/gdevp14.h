@@ -125,6 +125,8 @@ struct pdf14_parent_color_s {
 
 typedef struct pdf14_ctx_s pdf14_ctx;
 
+typedef struct pdf14_smask_cache_s pdf14_smask_cache_t;
+
 struct pdf14_buf_s {
     pdf14_buf *saved;
     byte *backdrop;  /* This is needed for proper non-isolated knockout support */
@@ -156,10 +158,25 @@ struct pdf14_buf_s {
     int matte_num_comps;
     uint16_t *matte;
     gs_int_rect dirty;
+    /* Large isolated groups are not cleared when they are pushed, but a
+       PDF14_TILE_SIZE square tile at a time as they are first marked.
+       While tile_clear is non-NULL it has a byte per tile (row major from
+       rect.p), set once that tile has been cleared; tiles_todo counts the
+       tiles still to clear. A tile that has not been cleared has never been
+       marked, so is entirely transparent. */
+    byte *tile_clear;
+    int tiles_x;
+    int tiles_y;
+    int tiles_todo;
     pdf14_mask_t *mask_stack;
     bool idle;
 
     gs_transparency_mask_subtype_t SMask_SubType;
+    /* A soft mask that is to be copied from smask_cache (moved by
+       smask_shift) when it is popped, or whose result is to be kept there
+       if smask_cache->data is still NULL. */
+    pdf14_smask_cache_t *smask_cache;
+    gs_int_point smask_shift;
 
     uint mask_id;
     pdf14_parent_color_t *parent_color_info;
@@ -168,6 +185,31 @@ struct pdf14_buf_s {
     gs_memory_t *memory;
 };
 
+/* Finished soft masks, as left by pdf14_pop_transparency_mask, are kept
+   for the life of the context. A later mask with the same cache_id (the
+   interpreter's name for the mask's content), inherited state, parameters
+   and matrix, give or take a whole pixel translation, is copied from here
+   and not drawn. */
+struct pdf14_smask_cache_s {
+    pdf14_smask_cache_t *next;
+    gs_id cache_id;
+    gs_id clip_id;              /* Clip cutting into the mask, or 0 */
+    int64_t state;              /* Hash of the state the content inherits */
+    gs_transparency_color_t group_color;
+    int64_t icc_hashcode;       /* Blending space of the mask group */
+    gs_transparency_mask_subtype_t subtype;
+    gs_matrix ctm;
+    gs_rect bbox;
+    gs_int_rect group_rect;     /* Device bbox of the mask, unclipped */
+    int Background_components;
+    float Background[GS_CLIENT_COLOR_MAX_COMPONENTS];
+    float GrayBackground;
+    gs_int_rect rect;           /* Area held in data */
+    int rowstride;
+    uint size;
+    byte *data;                 /* NULL until the mask has been popped */
+};
+
 typedef struct pdf14_smaskcolor_s {
     gsicc_smask_t *profiles;
     int           ref_count;
@@ -183,6 +225,8 @@ struct pdf14_ctx_s {
     int smask_depth;  /* used to catch smasks embedded in smasks.  bug691803 */
     bool smask_blend;
     bool deep; /* If true, 16 bit data, false, 8 bit data. */
+    pdf14_smask_cache_t *smask_cache;
+    uint smask_cache_size;
 };
 
 typedef struct gs_pdf14trans_params_s gs_pdf14trans_params_t;
@@ -212,6 +256,7 @@ typedef struct pdf14_device_s {
     int text_group;
     gx_color_index drawn_comps;		/* Used for overprinting.  Passed from overprint compositor */
     gx_device * pclist_device;
+    gs_int_rect page_rect;          /* Clist reader: only this area is composited, empty for all */
     bool free_devicen;              /* Used to avoid freeing a deviceN parameter from target clist device */
     bool sep_device;
     bool using_blend_cs;
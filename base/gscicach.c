@@ -12,8 +12,6 @@
    Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
    CA 94945, U.S.A., +1(415)492-9861, for further information.
 */
-
-
 /* A color index cache. */
 #include "gx.h"
 #include "gserrors.h"
@@ -23,20 +21,26 @@
 #include "gscicach.h"
 #include "memory_.h"
 
-#define COLOR_INDEX_CACHE_SIZE 256
-#define COLOR_INDEX_CACHE_CHAINS (COLOR_INDEX_CACHE_SIZE / 16)
+/* The cache is an open addressing hash table. Lookups probe a short
+   window of consecutive slots, comparing a 32 bit hash of the paint
+   values before touching the values themselves. The hashes live in
+   their own array so that a whole probe window shares a cache line.
+   When the window is full, the least recently used slot of the window
+   is replaced. */
+#define COLOR_INDEX_CACHE_SIZE 256 /* Must be a power of 2. */
+#define COLOR_INDEX_CACHE_PROBES 8
+/* Number of colors hashed together by gs_cached_color_indices. */
+#define COLOR_INDEX_CACHE_BATCH 32
 
 typedef struct gs_color_index_cache_elem_s gs_color_index_cache_elem_t;
 
 struct gs_color_index_cache_elem_s {
     union _color {
       gx_color_index cindex;
-      ushort devn[GS_CLIENT_COLOR_MAX_COMPONENTS];  
+      ushort devn[GS_CLIENT_COLOR_MAX_COMPONENTS];
     } color;
     gx_device_color_type color_type;
-    uint chain;
-    uint prev, next; /* NULL for unused. */
-    uint touch_prev, touch_next;
+    uint touch; /* Time of the last use, 0 for unused. */
     bool frac_values_done;
 };
 
@@ -48,21 +52,16 @@ struct gs_color_index_cache_s {
     int client_num_components;
     int device_num_components;
     gs_memory_t *memory;
-    int used;
+    uint clock;
+    uint32_t *hashes;
     gs_color_index_cache_elem_t *buf;
-    uint recent_touch;
     float *paint_values;
     frac31 *frac_values;
-    int chains[COLOR_INDEX_CACHE_CHAINS];
-    /* Note : the 0th element of buf, paint_values, frac_values is never used,
-       because we consider the index 0 as NULL
-       just for a faster initialization. */
-#   define MYNULL 0
 };
 
-gs_private_st_ptrs6(st_color_index_cache, gs_color_index_cache_t, "gs_color_index_cache_t",
+gs_private_st_ptrs7(st_color_index_cache, gs_color_index_cache_t, "gs_color_index_cache_t",
                     gs_color_index_cache_elem_ptrs, gs_color_index_cache_reloc_ptrs,
-                    direct_space, memory, buf, paint_values, frac_values, trans_dev);
+                    direct_space, memory, hashes, buf, paint_values, frac_values, trans_dev);
 
 gs_color_index_cache_t *
 gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_space, gx_device *dev,
@@ -70,6 +69,8 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
 {
     int client_num_components = cs_num_components(direct_space);
     int device_num_components = trans_dev->color_info.num_components;
+    uint32_t *hashes = (uint32_t *)gs_alloc_byte_array(memory, COLOR_INDEX_CACHE_SIZE,
+                    sizeof(uint32_t), "gs_color_index_cache_create");
     gs_color_index_cache_elem_t *buf = ( gs_color_index_cache_elem_t *)gs_alloc_byte_array(memory, COLOR_INDEX_CACHE_SIZE,
                     sizeof(gs_color_index_cache_elem_t), "gs_color_index_cache_create");
     float *paint_values = (float *)gs_alloc_byte_array(memory, COLOR_INDEX_CACHE_SIZE * client_num_components,
@@ -78,7 +79,8 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
                                             sizeof(frac31), "gs_color_index_cache_create") : NULL);
     gs_color_index_cache_t *pcic = gs_alloc_struct(memory, gs_color_index_cache_t, &st_color_index_cache, "gs_color_index_cache_create");
 
-    if (buf == NULL || paint_values == NULL || (need_frac && frac_values == NULL) || pcic == NULL) {
+    if (hashes == NULL || buf == NULL || paint_values == NULL || (need_frac && frac_values == NULL) || pcic == NULL) {
+        gs_free_object(memory, hashes, "gs_color_index_cache_create");
         gs_free_object(memory, buf, "gs_color_index_cache_create");
         gs_free_object(memory, paint_values, "gs_color_index_cache_create");
         gs_free_object(memory, frac_values, "gs_color_index_cache_create");
@@ -86,6 +88,7 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
         return NULL;
     }
     memset(pcic, 0, sizeof(*pcic));
+    memset(hashes, 0, COLOR_INDEX_CACHE_SIZE * sizeof(uint32_t));
     memset(buf, 0, COLOR_INDEX_CACHE_SIZE * sizeof(gs_color_index_cache_elem_t));
     pcic->direct_space = direct_space;
     pcic->pgs = pgs;
@@ -94,9 +97,9 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
     pcic->device_num_components = device_num_components;
     pcic->client_num_components = client_num_components;
     pcic->memory = memory;
-    pcic->used = 1; /* Never use the 0th element. */
+    pcic->clock = 0;
+    pcic->hashes = hashes;
     pcic->buf = buf;
-    pcic->recent_touch = MYNULL;
     pcic->paint_values = paint_values;
     pcic->frac_values = frac_values;
     return pcic;
@@ -105,135 +108,89 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
 void
 gs_color_index_cache_destroy(gs_color_index_cache_t *pcic)
 {
+    gs_free_object(pcic->memory, pcic->hashes, "gs_color_index_cache_create");
     gs_free_object(pcic->memory, pcic->buf, "gs_color_index_cache_create");
     gs_free_object(pcic->memory, pcic->paint_values, "gs_color_index_cache_create");
     gs_free_object(pcic->memory, pcic->frac_values, "gs_color_index_cache_create");
+    pcic->hashes = NULL;
     pcic->buf = NULL;
     pcic->paint_values = NULL;
     pcic->frac_values = NULL;
     gs_free_object(pcic->memory, pcic, "gs_color_index_cache_create");
 }
 
-static inline int
-hash_paint_values(const gs_color_index_cache_t *self, const float *paint_values)
+/* Hash the bit patterns of the paint values, so that equal hashes
+   are consistent with the memcmp used for the key comparison.
+   Only integer operations are used, and the loop over a batch
+   in hash_paint_values_array has no dependencies between colors,
+   so the compiler is free to vectorize it. */
+static inline uint32_t
+hash_paint_values(const float *paint_values, int num_components)
 {
+    uint32_t k = 0x811c9dc5;
     int i;
-    float v = 0;
-    uint k = 0;
-    const uint a_prime = 79;
-
-    for (i = 0; i < self->client_num_components; i++)
-        v = v * a_prime + paint_values[i];
-    /* Don't know the range of v, so hash its bytes : */
-    for(i = 0; i < sizeof(v); i++)
-        k = k * a_prime + ((byte *)&v)[i];
-    return k % COLOR_INDEX_CACHE_CHAINS;
-}
-
-static inline void
-exclude_from_chain(gs_color_index_cache_t *self, uint i)
-{
-    uint co = self->buf[i].chain;
-    uint ip = self->buf[i].prev, in = self->buf[i].next;
-
-    self->buf[ip].next = in;
-    self->buf[in].prev = ip;
-    if (self->chains[co] == i)
-        self->chains[co] = in;
-}
 
-static inline void
-include_into_chain(gs_color_index_cache_t *self, uint i, uint c)
-{
-    if (self->chains[c] != MYNULL) {
-        uint in = self->chains[c], ip = self->buf[in].prev;
+    for (i = 0; i < num_components; i++) {
+        uint32_t bits;
 
-        self->buf[i].next = in;
-        self->buf[i].prev = ip;
-        self->buf[in].prev = i;
-        self->buf[ip].next = i;
-    } else
-        self->buf[i].prev = self->buf[i].next = i;
-    self->chains[c] = i;
-    self->buf[i].chain = c;
-}
-
-static inline void
-exclude_from_touch_list(gs_color_index_cache_t *self, uint i)
-{
-    uint ip = self->buf[i].touch_prev, in = self->buf[i].touch_next;
-
-    self->buf[ip].touch_next = in;
-    self->buf[in].touch_prev = ip;
-    if (self->recent_touch == i) {
-        if (i == in)
-            self->recent_touch = MYNULL;
-        else
-            self->recent_touch = in;
+        memcpy(&bits, &paint_values[i], sizeof(bits));
+        k = (k ^ bits) * 0x9e3779b1;
     }
+    k ^= k >> 15;
+    /* Reserve 0 for unused slots. */
+    return k | 1;
 }
 
-static inline void
-include_into_touch_list(gs_color_index_cache_t *self, uint i)
+static void
+hash_paint_values_array(const float *paint_values, int num_components,
+                        int count, uint32_t *hashes)
 {
-    if (self->recent_touch != MYNULL) {
-        uint in = self->recent_touch, ip = self->buf[in].touch_prev;
+    int i;
 
-        self->buf[i].touch_next = in;
-        self->buf[i].touch_prev = ip;
-        self->buf[in].touch_prev = i;
-        self->buf[ip].touch_next = i;
-    } else
-        self->buf[i].touch_prev = self->buf[i].touch_next = i;
-    self->recent_touch = i;
+    for (i = 0; i < count; i++)
+        hashes[i] = hash_paint_values(paint_values + i * num_components, num_components);
 }
 
+/* Returns 1 if found, 0 if a slot was allocated for a new color. */
 static int
-get_color_index_cache_elem(gs_color_index_cache_t *self, 
-                           const float *paint_values, uint *pi)
+get_color_index_cache_elem(gs_color_index_cache_t *self,
+                           const float *paint_values, uint32_t hash, uint *pi)
 {
     int client_num_components = self->client_num_components;
-    uint c = hash_paint_values(self, paint_values);
-    uint i = self->chains[c], j;
-
-    if (i != MYNULL) {
-        uint tries = 16; /* Arbitrary. */
+    uint start = hash & (COLOR_INDEX_CACHE_SIZE - 1);
+    uint victim = start, j;
+    uint touch = ++self->clock;
+
+    if (touch == 0) {
+        /* The clock wrapped. Keep the slots in use, but forget the ages. */
+        for (j = 0; j < COLOR_INDEX_CACHE_SIZE; j++)
+            if (self->buf[j].touch)
+                self->buf[j].touch = 1;
+        touch = self->clock = 2;
+    }
+    for (j = 0; j < COLOR_INDEX_CACHE_PROBES; j++) {
+        uint i = (start + j) & (COLOR_INDEX_CACHE_SIZE - 1);
 
-        if (!memcmp(paint_values, self->paint_values + i * client_num_components, 
+        if (self->hashes[i] == hash &&
+            !memcmp(paint_values, self->paint_values + i * client_num_components,
                     sizeof(*paint_values) * client_num_components)) {
-            if (self->recent_touch != i) {
-                exclude_from_touch_list(self, i);
-                include_into_touch_list(self, i);
-            }
+            self->buf[i].touch = touch;
             *pi = i;
             return 1;
         }
-        for (j = self->buf[i].next; tries -- && j != i; j = self->buf[j].next) {
-            if (!memcmp(paint_values, self->paint_values + j * client_num_components, 
-                        sizeof(*paint_values) * client_num_components)) {
-                exclude_from_chain(self, j);
-                include_into_chain(self, j, c);
-                if (self->recent_touch != j) {
-                    exclude_from_touch_list(self, j);
-                    include_into_touch_list(self, j);
-                }
-                *pi = j;
-                return 1;
-            }
+        if (self->hashes[i] == 0) {
+            /* An empty slot ends the probe sequence. At worst this
+               misses a color stored past a slot released by a failed
+               remap, which just makes a duplicate entry. */
+            victim = i;
+            break;
         }
+        if (self->buf[i].touch < self->buf[victim].touch)
+            victim = i;
     }
-    if (self->used < COLOR_INDEX_CACHE_SIZE) {
-        /* Use a new one */
-        i = self->used++;
-        include_into_touch_list(self, i);
-    } else {
-        i = self->recent_touch;
-        self->recent_touch = self->buf[i].touch_prev; /* Assuming the cyclic list,
-                                                      just move the head pointer to the last element. */
-        exclude_from_chain(self, i);
-    }
-    include_into_chain(self, i, c);
-    *pi = i;
+    self->hashes[victim] = hash;
+    self->buf[victim].touch = touch;
+    *pi = victim;
     return 0;
 }
 
@@ -251,24 +208,24 @@ compute_frac_values(gs_color_index_cache_t *self, uint i)
         for (j = 0; j < device_num_components; j++) {
                 int shift = cinfo->comp_shift[j];
                 int bits = cinfo->comp_bits[j];
-                self->frac_values[i * device_num_components + j] = 
-                    ((c >> shift) & ((1 << bits) - 1)) << 
+                self->frac_values[i * device_num_components + j] =
+                    ((c >> shift) & ((1 << bits) - 1)) <<
                     (sizeof(frac31) * 8 - 1 - bits);
         }
         self->buf[i].frac_values_done = true;
     } else {
         /* Must be devn */
         for (j = 0; j < device_num_components; j++) {
-            self->frac_values[i * device_num_components + j] = 
+            self->frac_values[i * device_num_components + j] =
                 cv2frac31(self->buf[i].color.devn[j]);
         }
         self->buf[i].frac_values_done = true;
     }
 }
 
-int
-gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values, 
-                      gx_device_color *pdevc, frac31 *frac_values)
+static int
+cached_color_index_hashed(gs_color_index_cache_t *self, const float *paint_values,
+                          uint32_t hash, gx_device_color *pdevc, frac31 *frac_values)
 {
     /* Must return 2 if the color is not pure.
        See patch_color_to_device_color. */
@@ -278,12 +235,12 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
     uint i, j;
     int code;
 
-    if (get_color_index_cache_elem(self, paint_values, &i)) {
+    if (get_color_index_cache_elem(self, paint_values, hash, &i)) {
         if (pdevc != NULL) {
             if (self->buf[i].color_type == &gx_dc_type_data_pure) {
                 pdevc->colors.pure = self->buf[i].color.cindex;
                 pdevc->type = &gx_dc_type_data_pure;
-                memcpy(pdevc->ccolor.paint.values, paint_values, 
+                memcpy(pdevc->ccolor.paint.values, paint_values,
                        sizeof(*paint_values) * client_num_components);
             } else {
                 /* devn case */
@@ -291,7 +248,7 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
                     pdevc->colors.devn.values[j] = self->buf[i].color.devn[j];
                 }
                 pdevc->type = &gx_dc_type_data_devn;
-                memcpy(pdevc->ccolor.paint.values, paint_values, 
+                memcpy(pdevc->ccolor.paint.values, paint_values,
                        sizeof(*paint_values) * client_num_components);
             }
             pdevc->ccolor_valid = true;
@@ -304,22 +261,25 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
 
         if (pdevc == NULL)
             pdevc = &devc_local;
-        memcpy(self->paint_values + i * client_num_components, paint_values, 
+        memcpy(self->paint_values + i * client_num_components, paint_values,
                sizeof(*paint_values) * client_num_components);
-        memcpy(fcc.paint.values, paint_values, 
+        memcpy(fcc.paint.values, paint_values,
                sizeof(*paint_values) * client_num_components);
-        code = pcs->type->remap_color(&fcc, pcs, pdevc, self->pgs, 
+        code = pcs->type->remap_color(&fcc, pcs, pdevc, self->pgs,
                                       self->trans_dev, gs_color_select_texture);
-        if (code < 0)
-            return code;
+        if (code < 0 || !(pdevc->type == &gx_dc_type_data_pure ||
+                          pdevc->type == &gx_dc_type_data_devn)) {
+            /* Don't leave a half-filled slot behind. */
+            self->hashes[i] = 0;
+            self->buf[i].touch = 0;
+            return (code < 0 ? code : 2);
+        }
         if (pdevc->type == &gx_dc_type_data_pure) {
             self->buf[i].color.cindex = pdevc->colors.pure;
-        } else if (pdevc->type == &gx_dc_type_data_devn) {
+        } else {
             for (j = 0; j < device_num_components; j++) {
                 self->buf[i].color.devn[j] = pdevc->colors.devn.values[j];
             }
-        } else {
-            return 2;
         }
         self->buf[i].color_type = pdevc->type;
         if (frac_values != NULL)
@@ -328,7 +288,41 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
             self->buf[i].frac_values_done = false;
     }
     if (frac_values != NULL)
-        memcpy(frac_values, self->frac_values + i * device_num_components, 
+        memcpy(frac_values, self->frac_values + i * device_num_components,
                sizeof(*frac_values) * device_num_components);
     return 0;
 }
+
+int
+gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
+                      gx_device_color *pdevc, frac31 *frac_values)
+{
+    return cached_color_index_hashed(self, paint_values,
+                hash_paint_values(paint_values, self->client_num_components),
+                pdevc, frac_values);
+}
+
+int
+gs_cached_color_indices(gs_color_index_cache_t *self, const float *paint_values,
+                        int count, gx_device_color *pdevc,
+                        frac31 *frac_values, int frac_stride)
+{
+    int client_num_components = self->client_num_components;
+    uint32_t hashes[COLOR_INDEX_CACHE_BATCH];
+    int i, j, n, code;
+
+    for (i = 0; i < count; i += n) {
+        n = min(count - i, COLOR_INDEX_CACHE_BATCH);
+        hash_paint_values_array(paint_values + i * client_num_components,
+                                client_num_components, n, hashes);
+        for (j = 0; j < n; j++) {
+            code = cached_color_index_hashed(self,
+                        paint_values + (i + j) * client_num_components, hashes[j],
+                        (pdevc == NULL ? NULL : pdevc + i + j),
+                        (frac_values == NULL ? NULL : frac_values + (i + j) * frac_stride));
+            if (code != 0)
+                return code;
+        }
+    }
+    return 0;
+}
@@ -29,4 +29,12 @@ void gs_color_index_cache_destroy(gs_color_index_cache_t *this);
 
 int gs_cached_color_index(gs_color_index_cache_t *this, const float *paint_values, gx_device_color *pdevc, frac31 *frac_values);
 
+/* Convert count colors, stored contiguously with cs_num_components
+   paint values per color. pdevc (if not NULL) receives count device colors,
+   frac_values (if not NULL) receives count rows of frac_stride values.
+   Stops at the first color that fails or isn't pure, returning its code. */
+int gs_cached_color_indices(gs_color_index_cache_t *this, const float *paint_values,
+                            int count, gx_device_color *pdevc,
+                            frac31 *frac_values, int frac_stride);
+
 #endif /* gscicach_INCLUDED */
@@ -162,11 +162,13 @@ code_map_decode_next_multidim_regime(const gx_code_map_t * pcmap,
     const byte *str = pstr->data + *pindex;
     uint ssize = pstr->size - *pindex;
     /*
-     * The keys are not sorted due to 'usecmap'.  Possible optimization :
-     * merge and sort keys in 'zbuildcmap', then use binary search here.
-     * This would be valuable for UniJIS-UTF8-H, which contains about 7000
-     * keys.
+     * The keys are not sorted due to 'usecmap', so we can't binary search
+     * them.  Instead, if the map is indexed, only try the ranges that can
+     * match the first byte of the code.  The others couldn't produce even
+     * a partial match.
      */
+    const uint *pidx = NULL;
+    int n;
     int i;
 
     /*
@@ -193,15 +195,25 @@ code_map_decode_next_multidim_regime(const gx_code_map_t * pcmap,
 #endif
 #endif
 
-    for (i = pcmap->num_lookup - 1; i >= 0; --i) {
+    if (pcmap->index != NULL && ssize > 0) {
+        pidx = pcmap->index + 257 + pcmap->index[str[0]];
+        n = pcmap->index[str[0] + 1] - pcmap->index[str[0]];
+    } else
+        n = pcmap->num_lookup;
+
+    for (; n > 0; --n) {
         /* main loop - scan the map passed via pcmap */
         /* reverse scan order due to 'usecmap' */
 
-        const gx_cmap_lookup_range_t *pclr = &pcmap->lookup[i];
-        int pre_size = pclr->key_prefix_size, key_size = pclr->key_size,
-            chr_size = pre_size + key_size;
-
+        const gx_cmap_lookup_range_t *pclr;
+        int pre_size, key_size, chr_size;
         int j = 0;
+
+        i = (pidx != NULL ? *pidx++ : n - 1);
+        pclr = &pcmap->lookup[i];
+        pre_size = pclr->key_prefix_size;
+        key_size = pclr->key_size;
+        chr_size = pre_size + key_size;
         /* length of the given byte stream is shorter than
          * chr-length of current range, no need for further check,
          * skip to the next range.
@@ -630,8 +642,78 @@ gs_cmap_adobe1_alloc(gs_cmap_adobe1_t **ppcmap, int wmode,
     }
     pcmap1->def.lookup = lookups;
     pcmap1->def.num_lookup = num_lookups;
+    pcmap1->def.index = 0;
     pcmap1->notdef.lookup = 0;
     pcmap1->notdef.num_lookup = 0;
+    pcmap1->notdef.index = 0;
     /* no mark_glyph, mark_glyph_data, glyph_name, glyph_name_data */
     return 0;
 }
+
+/* Don't bother indexing maps with only a few lookup ranges. */
+#define CMAP_INDEX_MIN_LOOKUPS 8
+
+/* Mark the first bytes of the codes a lookup range can match. */
+static void
+lookup_range_first_bytes(const gx_cmap_lookup_range_t *pclr, byte first[256])
+{
+    if (pclr->key_prefix_size > 0) {
+        memset(first, 0, 256);
+        first[pclr->key_prefix[0]] = 1;
+    } else if (pclr->key_size == 0)
+        memset(first, 1, 256);
+    else {
+        int step = pclr->key_size * (pclr->key_is_range ? 2 : 1);
+        const byte *key = pclr->keys.data;
+        int k, c;
+
+        memset(first, 0, 256);
+        for (k = 0; k < pclr->num_entries; ++k, key += step)
+            for (c = key[0]; c <= key[step - pclr->key_size]; ++c)
+                first[c] = 1;
+    }
+}
+
+int
+gs_cmap_adobe1_index_code_map(gx_code_map_t *pcmap, gs_memory_t *mem)
+{
+    byte first[256];
+    uint *index;
+    uint count = 0;
+    int c, i;
+
+    pcmap->index = 0;
+    if (pcmap->num_lookup < CMAP_INDEX_MIN_LOOKUPS)
+        return 0;
+    for (i = 0; i < pcmap->num_lookup; ++i) {
+        lookup_range_first_bytes(&pcmap->lookup[i], first);
+        for (c = 0; c < 256; ++c)
+            count += first[c];
+    }
+    index = (uint *)gs_alloc_byte_array(mem, 257 + count, sizeof(uint),
+                                        "gs_cmap_adobe1_index_code_map");
+    if (index == 0)
+        return_error(gs_error_VMerror);
+    /* Count the ranges for each first byte, then turn the counts */
+    /* into offsets and fill in the lists, in decoding order. */
+    memset(index, 0, 257 * sizeof(uint));
+    for (i = 0; i < pcmap->num_lookup; ++i) {
+        lookup_range_first_bytes(&pcmap->lookup[i], first);
+        for (c = 0; c < 256; ++c)
+            index[c + 1] += first[c];
+    }
+    for (c = 0; c < 256; ++c)
+        index[c + 1] += index[c];
+    for (i = pcmap->num_lookup - 1; i >= 0; --i) {
+        lookup_range_first_bytes(&pcmap->lookup[i], first);
+        for (c = 0; c < 256; ++c)
+            if (first[c])
+                index[257 + index[c]++] = i;
+    }
+    /* The fill moved each offset up to the start of the next list. */
+    for (c = 256; c > 0; --c)
+        index[c] = index[c - 1];
+    index[0] = 0;
+    pcmap->index = index;
+    return 0;
+}
@@ -35,12 +35,14 @@
 #define mmax_LARGE 200		/* mmax - # of cached font/matrix pairs */
 #define cmax_LARGE 5000		/* cmax - # of cached chars */
 #define blimit_LARGE 32000	/* blimit/upper - max size of a single cached char */
+#define btarget_LARGE 4000000	/* btarget - limit for adaptive growth of bmax */
 /*** Small memory machines ***/
 #define smax_SMALL 20		/* smax - # of scaled fonts */
 #define bmax_SMALL 25000	/* bmax - space for cached chars */
 #define mmax_SMALL 40		/* mmax - # of cached font/matrix pairs */
 #define cmax_SMALL 500		/* cmax - # of cached chars */
 #define blimit_SMALL 100	/* blimit/upper - max size of a single cached char */
+#define btarget_SMALL 100000	/* btarget - limit for adaptive growth of bmax */
 
 /* Define a default procedure vector for fonts. */
 const gs_font_procs gs_font_procs_default = {
@@ -214,6 +216,10 @@ cc_no_mark_glyph(const gs_memory_t *mem, gs_glyph glyph, void *ignore_data)
 {
     return false;
 }
+static gs_font_dir *font_dir_alloc(gs_memory_t * struct_mem,
+                                   gs_memory_t * bits_mem, uint smax,
+                                   uint bmax, uint btarget, uint mmax,
+                                   uint cmax, uint upper);
 gs_font_dir *
 gs_font_dir_alloc2(gs_memory_t * struct_mem, gs_memory_t * bits_mem)
 {
@@ -225,24 +231,32 @@ gs_font_dir_alloc2(gs_memory_t * struct_mem, gs_memory_t * bits_mem)
 #  endif
     {				/* Try allocating a very large cache. */
         /* If this fails, allocate a small one. */
-        pdir = gs_font_dir_alloc2_limits(struct_mem, bits_mem,
-                                         smax_LARGE, bmax_LARGE, mmax_LARGE,
-                                         cmax_LARGE, blimit_LARGE);
+        pdir = font_dir_alloc(struct_mem, bits_mem,
+                              smax_LARGE, bmax_LARGE, btarget_LARGE,
+                              mmax_LARGE, cmax_LARGE, blimit_LARGE);
     }
     if (pdir == 0)
 #endif
-        pdir = gs_font_dir_alloc2_limits(struct_mem, bits_mem,
-                                         smax_SMALL, bmax_SMALL, mmax_SMALL,
-                                         cmax_SMALL, blimit_SMALL);
+        pdir = font_dir_alloc(struct_mem, bits_mem,
+                              smax_SMALL, bmax_SMALL, btarget_SMALL,
+                              mmax_SMALL, cmax_SMALL, blimit_SMALL);
     if (pdir == 0)
         return 0;
     pdir->ccache.mark_glyph = cc_no_mark_glyph;
     pdir->ccache.mark_glyph_data = 0;
     return pdir;
 }
+/* Explicit limits are kept: the character cache doesn't grow. */
 gs_font_dir *
 gs_font_dir_alloc2_limits(gs_memory_t * struct_mem, gs_memory_t * bits_mem,
                      uint smax, uint bmax, uint mmax, uint cmax, uint upper)
+{
+    return font_dir_alloc(struct_mem, bits_mem, smax, bmax, bmax, mmax,
+                          cmax, upper);
+}
+static gs_font_dir *
+font_dir_alloc(gs_memory_t * struct_mem, gs_memory_t * bits_mem, uint smax,
+               uint bmax, uint btarget, uint mmax, uint cmax, uint upper)
 {
     gs_font_dir *pdir =
         gs_alloc_struct(struct_mem, gs_font_dir, &st_font_dir,
@@ -253,7 +267,7 @@ gs_font_dir_alloc2_limits(gs_memory_t * struct_mem, gs_memory_t * bits_mem,
         return 0;
     memset(pdir, 0, sizeof(*pdir));
     code = gx_char_cache_alloc(struct_mem, bits_mem, pdir,
-                               bmax, mmax, cmax, upper);
+                               bmax, btarget, mmax, cmax, upper);
     if (code < 0) {
         gs_free_object(struct_mem, pdir->ccache.table, "font_dir_alloc(chars)");
         gs_free_object(struct_mem, pdir->fmcache.mdata, "font_dir_alloc(mdata)");
@@ -267,6 +281,7 @@ gs_font_dir_alloc2_limits(gs_memory_t * struct_mem, gs_memory_t * bits_mem,
     pdir->align_to_pixels = false;
     pdir->glyph_to_unicode_table = NULL;
     pdir->grid_fit_tt = 1;
+    pdir->subpixel_phases = 0;
     pdir->memory = struct_mem;
     pdir->tti = 0;
     pdir->ttm = 0;
@@ -665,6 +680,51 @@ gs_cachestatus(register const gs_font_dir * pdir, register uint pstat[7])
     pstat[6] = pdir->ccache.upper;
 }
 
+/* Get the character cache statistics. */
+void
+gs_cachestats(const gs_font_dir * pdir, gs_font_cache_stats * pstats)
+{
+    pstats->lookups = pdir->ccache.lookups;
+    pstats->hits = pdir->ccache.hits;
+    pstats->misses = pdir->ccache.lookups - pdir->ccache.hits;
+    pstats->additions = pdir->ccache.additions;
+    pstats->evictions = pdir->ccache.evictions;
+    pstats->bytes = pdir->ccache.bsize;
+    pstats->bmax = pdir->ccache.bmax;
+    pstats->bmax_target = pdir->ccache.bmax_target;
+    pstats->grows = pdir->ccache.grows;
+    pstats->pairs = pdir->fmcache.msize;
+}
+
+void
+gs_print_cachestats(const gs_font_dir * pdir, const gs_memory_t * mem)
+{
+    gs_font_cache_stats stats;
+    uint i;
+
+    gs_cachestats(pdir, &stats);
+    dmprintf5(mem, "%% Font cache: lookups = %lu, hits = %lu, misses = %lu, additions = %lu, evictions = %lu\n",
+              stats.lookups, stats.hits, stats.misses, stats.additions,
+              stats.evictions);
+    dmprintf5(mem, "%% Font cache: bytes = %u, bmax = %u, target = %u, grows = %u, pairs = %u\n",
+              stats.bytes, stats.bmax, stats.bmax_target, stats.grows,
+              stats.pairs);
+    for (i = 0; i < pdir->fmcache.unused; i++) {
+        const cached_fm_pair *pair = &pdir->fmcache.mdata[i];
+        const gs_font *font = pair->font;
+
+        if (fm_pair_is_free(pair))
+            continue;
+        dmprintf8(mem, "%%   pair %u %.*s [%g %g %g %g]: chars = %d,",
+                  i, (int)(font ? font->font_name.size : 0),
+                  (font ? (const char *)font->font_name.chars : ""),
+                  pair->mxx, pair->mxy, pair->myx, pair->myy,
+                  pair->num_chars);
+        dmprintf2(mem, " lookups = %lu, hits = %lu\n",
+                  pair->lookups, pair->hits);
+    }
+}
+
 /* setcacheparams */
 int
 gs_setcachesize(gs_gstate * pgs, gs_font_dir * pdir, uint size)
@@ -694,7 +754,8 @@ gs_setcachesize(gs_gstate * pgs, gs_font_dir * pdir, uint size)
     gs_free_object(stable_mem, pdir->ccache.table, "gs_setcachesize(table)");
     pdir->ccache.bmax = size;
     return gx_char_cache_alloc(stable_mem, stable_mem->non_gc_memory, pdir,
-                               pdir->ccache.bmax, pdir->fmcache.mmax,
+                               pdir->ccache.bmax, pdir->ccache.bmax,
+                               pdir->fmcache.mmax,
                                pdir->ccache.cmax, pdir->ccache.upper);
 }
 
@@ -722,6 +783,21 @@ gs_setgridfittt(gs_font_dir * pdir, uint v)
     pdir->grid_fit_tt = v;
     return 0;
 }
+int
+gs_setsubpixelphases(gs_font_dir * pdir, uint v)
+{
+    uint phases = 1;
+
+    /* Round down to a power of 2 no finer than a fixed unit. */
+    if (v == 0) {
+        pdir->subpixel_phases = 0;
+        return 0;
+    }
+    while (phases * 2 <= v && phases * 2 <= fixed_1)
+        phases *= 2;
+    pdir->subpixel_phases = phases;
+    return 0;
+}
 
 /* currentcacheparams */
 uint
@@ -749,6 +825,11 @@ gs_currentgridfittt(const gs_font_dir * pdir)
 {
     return pdir->grid_fit_tt;
 }
+uint
+gs_currentsubpixelphases(const gs_font_dir * pdir)
+{
+    return pdir->subpixel_phases;
+}
 
 /* Purge a font from all font- and character-related tables. */
 /* This is only used by restore (and, someday, the GC). */
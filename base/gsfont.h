@@ -72,6 +72,23 @@ gs_font *gs_find_font_by_id(gs_font_dir *pdir, gs_id id, gs_matrix *FontMatrix);
 /* Font cache parameter operations */
 void gs_cachestatus(const gs_font_dir *, uint[7]);
 
+/* Character cache statistics, accumulated since the cache was created. */
+typedef struct gs_font_cache_stats_s {
+    ulong lookups;		/* cached glyph lookups */
+    ulong hits;			/* lookups that found a glyph */
+    ulong misses;		/* lookups - hits */
+    ulong additions;		/* glyphs added to the cache */
+    ulong evictions;		/* glyphs discarded to make room */
+    uint bytes;			/* space used by cached glyphs */
+    uint bmax;			/* current limit on bytes */
+    uint bmax_target;		/* limit for adaptive growth of bmax */
+    uint grows;			/* # of times bmax was raised */
+    uint pairs;			/* # of cached font/matrix pairs */
+} gs_font_cache_stats;
+void gs_cachestats(const gs_font_dir *, gs_font_cache_stats *);
+/* Print the statistics, and the counts for each font/matrix pair. */
+void gs_print_cachestats(const gs_font_dir *, const gs_memory_t *);
+
 #define gs_setcachelimit(pdir,limit) gs_setcacheupper(pdir,limit)
 uint gs_currentcachesize(const gs_font_dir *);
 int gs_setcachesize(gs_gstate * pgs, gs_font_dir *, uint);
@@ -83,5 +100,7 @@ uint gs_currentaligntopixels(const gs_font_dir *);
 int gs_setaligntopixels(gs_font_dir *, uint);
 uint gs_currentgridfittt(const gs_font_dir *);
 int gs_setgridfittt(gs_font_dir *, uint);
+uint gs_currentsubpixelphases(const gs_font_dir *);
+int gs_setsubpixelphases(gs_font_dir *, uint);
 
 #endif /* gsfont_INCLUDED */
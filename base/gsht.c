@@ -27,6 +27,8 @@
 #include "gxdevice.h"           /* for gzht.h */
 #include "gzht.h"
 #include "gxfmap.h"             /* For effective transfer usage in threshold */
+#include "gxsync.h"             /* for the spot order cache monitor */
+#include "gslibctx.h"
 
 /* Forward declarations */
 void gx_set_effective_transfer(gs_gstate *);
@@ -461,6 +463,194 @@ gx_sort_ht_order(gx_ht_bit * recs, uint N)
 #endif
 }
 
+/*
+ * Spot orders built from identical samples are identical, and a process
+ * typically sets the same few screens for every job (and every rendering
+ * thread of a job re-installs the halftone of the main thread).  Keep the
+ * finished levels and bits of recently constructed orders in the library
+ * core, so that gx_ht_construct_spot_order can skip the sort and the bit
+ * construction.  The cache is shared by all the contexts that share the
+ * core, lives as long as the core, and is protected by the core monitor.
+ */
+#define HT_ORDER_CACHE_SIZE 8
+#define HT_ORDER_CACHE_MAX_BYTES (4 * 1024 * 1024)
+
+typedef struct ht_order_cache_entry_s {
+    uint hash;                  /* 0 = unused */
+    ushort width;
+    ushort orig_height;
+    ushort orig_shift;
+    uint full_height;
+    uint num_levels;
+    uint num_bits;
+    ulong last_used;
+    gx_ht_bit *bits;            /* num_bits, followed by... */
+    uint *levels;               /* num_levels, followed by... */
+    ht_sample_t *samples;       /* num_levels, the key */
+} ht_order_cache_entry_t;
+
+typedef struct ht_order_cache_s {
+    ulong clock;
+    ht_order_cache_entry_t entries[HT_ORDER_CACHE_SIZE];
+} ht_order_cache_t;
+
+static void
+ht_order_cache_free(gs_memory_t *mem, void *data)
+{
+    ht_order_cache_t *cache = (ht_order_cache_t *)data;
+    int i;
+
+    for (i = 0; i < HT_ORDER_CACHE_SIZE; i++)
+        gs_free_object(mem, cache->entries[i].bits, "ht_order_cache_free(entry)");
+    gs_free_object(mem, cache, "ht_order_cache_free");
+}
+
+/* Hash the geometry and the samples of an unsorted spot order. */
+static uint
+ht_order_cache_hash(const gx_ht_order *porder)
+{
+    const gx_ht_bit *bits = (const gx_ht_bit *)porder->bit_data;
+    uint hash = 2166136261u;
+    uint i;
+
+#define HT_HASH(v) (hash = (hash ^ (uint)(v)) * 16777619u)
+    HT_HASH(porder->width);
+    HT_HASH(porder->orig_height);
+    HT_HASH(porder->orig_shift);
+    HT_HASH(porder->full_height);
+    HT_HASH(porder->num_levels);
+    HT_HASH(porder->num_bits);
+    for (i = 0; i < porder->num_levels; i++)
+        HT_HASH(bits[i].mask);
+#undef HT_HASH
+    return (hash == 0 ? 1 : hash);
+}
+
+static bool
+ht_order_cache_same_geometry(const ht_order_cache_entry_t *pe, uint hash,
+                             const gx_ht_order *porder)
+{
+    return (pe->hash == hash && pe->width == porder->width &&
+            pe->orig_height == porder->orig_height &&
+            pe->orig_shift == porder->orig_shift &&
+            pe->full_height == porder->full_height &&
+            pe->num_levels == porder->num_levels &&
+            pe->num_bits == porder->num_bits);
+}
+
+/*
+ * Look up a sampled order.  On a hit, copy the constructed levels and bits
+ * into the order and return true.  Otherwise return false; *hash is set
+ * for a later ht_order_cache_store.
+ */
+static bool
+ht_order_cache_lookup(gs_lib_ctx_core_t *core, gx_ht_order *porder, uint *hash)
+{
+    const gx_ht_bit *bits = (const gx_ht_bit *)porder->bit_data;
+    ht_order_cache_t *cache;
+    bool found = false;
+    int i;
+
+    *hash = ht_order_cache_hash(porder);
+    gx_monitor_enter((gx_monitor_t *)core->monitor);
+    cache = (ht_order_cache_t *)core->ht_order_cache;
+    if (cache != NULL) {
+        for (i = 0; i < HT_ORDER_CACHE_SIZE; i++) {
+            ht_order_cache_entry_t *pe = &cache->entries[i];
+            uint j;
+
+            if (!ht_order_cache_same_geometry(pe, *hash, porder))
+                continue;
+            for (j = 0; j < pe->num_levels; j++)
+                if (pe->samples[j] != bits[j].mask)
+                    break;
+            if (j == pe->num_levels) {
+                memcpy(porder->bit_data, pe->bits,
+                       pe->num_bits * sizeof(gx_ht_bit));
+                memcpy(porder->levels, pe->levels,
+                       pe->num_levels * sizeof(uint));
+                pe->last_used = ++cache->clock;
+                found = true;
+                break;
+            }
+        }
+    }
+    gx_monitor_leave((gx_monitor_t *)core->monitor);
+    return found;
+}
+
+/*
+ * Remember a constructed order, replacing the least recently used entry.
+ * The samples have been overwritten by the construction, so the caller
+ * passes a copy of them.  Failure to allocate just means no caching.
+ */
+static void
+ht_order_cache_store(gs_lib_ctx_core_t *core, const gx_ht_order *porder,
+                     uint hash, const ht_sample_t *samples)
+{
+    gs_memory_t *mem = core->memory;
+    size_t size = porder->num_bits * sizeof(gx_ht_bit) +
+        porder->num_levels * (sizeof(uint) + sizeof(ht_sample_t));
+    ht_order_cache_t *cache;
+    ht_order_cache_entry_t *pe;
+    gx_ht_bit *block;
+    int i;
+
+    if (size > HT_ORDER_CACHE_MAX_BYTES / HT_ORDER_CACHE_SIZE)
+        return;
+    block = (gx_ht_bit *)gs_alloc_bytes(mem, size, "ht_order_cache_store");
+    if (block == NULL)
+        return;
+    memcpy(block, porder->bit_data, porder->num_bits * sizeof(gx_ht_bit));
+    memcpy(block + porder->num_bits, porder->levels,
+           porder->num_levels * sizeof(uint));
+    memcpy((uint *)(block + porder->num_bits) + porder->num_levels, samples,
+           porder->num_levels * sizeof(ht_sample_t));
+
+    gx_monitor_enter((gx_monitor_t *)core->monitor);
+    cache = (ht_order_cache_t *)core->ht_order_cache;
+    if (cache == NULL) {
+        cache = (ht_order_cache_t *)gs_alloc_bytes(mem, sizeof(*cache),
+                                                   "ht_order_cache_store");
+        if (cache == NULL) {
+            gx_monitor_leave((gx_monitor_t *)core->monitor);
+            gs_free_object(mem, block, "ht_order_cache_store");
+            return;
+        }
+        memset(cache, 0, sizeof(*cache));
+        core->ht_order_cache = cache;
+        core->ht_order_cache_free = ht_order_cache_free;
+    }
+    pe = &cache->entries[0];
+    for (i = 0; i < HT_ORDER_CACHE_SIZE; i++) {
+        ht_order_cache_entry_t *pi = &cache->entries[i];
+
+        /* Another thread may have stored the same order meanwhile. */
+        if (ht_order_cache_same_geometry(pi, hash, porder) &&
+            !memcmp(pi->samples, samples,
+                    porder->num_levels * sizeof(ht_sample_t))) {
+            gx_monitor_leave((gx_monitor_t *)core->monitor);
+            gs_free_object(mem, block, "ht_order_cache_store");
+            return;
+        }
+        if (pi->hash == 0 || pi->last_used < pe->last_used)
+            pe = pi;
+    }
+    gs_free_object(mem, pe->bits, "ht_order_cache_store(evict)");
+    pe->hash = hash;
+    pe->width = porder->width;
+    pe->orig_height = porder->orig_height;
+    pe->orig_shift = porder->orig_shift;
+    pe->full_height = porder->full_height;
+    pe->num_levels = porder->num_levels;
+    pe->num_bits = porder->num_bits;
+    pe->bits = block;
+    pe->levels = (uint *)(block + porder->num_bits);
+    pe->samples = (ht_sample_t *)(pe->levels + porder->num_levels);
+    pe->last_used = ++cache->clock;
+    gx_monitor_leave((gx_monitor_t *)core->monitor);
+}
+
 /*
  * Construct the halftone order from a sampled spot function.  Only width x
  * strip samples have been filled in; we must replicate the resulting sorted
@@ -480,32 +670,56 @@ gx_ht_construct_spot_order(gx_ht_order * porder)
     uint num_bits = porder->num_bits;
     uint copies = num_bits / (width * strip);
     gx_ht_bit *bp = bits + num_bits - 1;
+    gs_lib_ctx_core_t *core = NULL;
+    ht_sample_t *samples = NULL;
+    uint hash = 0;
     uint i;
 
-    gx_sort_ht_order(bits, num_levels);
-    if_debug5('h',
-              "[h]spot order: num_levels=%u w=%u h=%u strip=%u shift=%u\n",
-              num_levels, width, porder->orig_height, strip, shift);
-    /* Fill in the levels array, replicating the bits vertically */
-    /* if needed. */
-    for (i = num_levels; i > 0;) {
-        uint offset = bits[--i].offset;
-        uint x = offset % width;
-        uint hy = offset - x;
-        uint k;
-
-        levels[i] = i * copies;
-        for (k = 0; k < copies;
-             k++, bp--, hy += num_levels, x = (x + width - shift) % width
-            )
-            bp->offset = hy + x;
+    if (porder->data_memory != NULL &&
+        porder->data_memory->gs_lib_ctx != NULL &&
+        porder->data_memory->gs_lib_ctx->core->monitor != NULL)
+        core = porder->data_memory->gs_lib_ctx->core;
+    if (core != NULL && ht_order_cache_lookup(core, porder, &hash)) {
+        if_debug3('h', "[h]spot order cache hit: num_levels=%u w=%u h=%u\n",
+                  num_levels, width, porder->orig_height);
+    } else {
+        if (core != NULL) {
+            samples = (ht_sample_t *)gs_alloc_bytes(core->memory,
+                                        num_levels * sizeof(ht_sample_t),
+                                        "gx_ht_construct_spot_order");
+            if (samples != NULL)
+                for (i = 0; i < num_levels; i++)
+                    samples[i] = bits[i].mask;
+        }
+        gx_sort_ht_order(bits, num_levels);
+        if_debug5('h',
+                  "[h]spot order: num_levels=%u w=%u h=%u strip=%u shift=%u\n",
+                  num_levels, width, porder->orig_height, strip, shift);
+        /* Fill in the levels array, replicating the bits vertically */
+        /* if needed. */
+        for (i = num_levels; i > 0;) {
+            uint offset = bits[--i].offset;
+            uint x = offset % width;
+            uint hy = offset - x;
+            uint k;
+
+            levels[i] = i * copies;
+            for (k = 0; k < copies;
+                 k++, bp--, hy += num_levels, x = (x + width - shift) % width
+                )
+                bp->offset = hy + x;
+        }
+        gx_ht_construct_bits(porder);
+        if (samples != NULL) {
+            ht_order_cache_store(core, porder, hash, samples);
+            gs_free_object(core->memory, samples, "gx_ht_construct_spot_order");
+        }
     }
     /* If we have a complete halftone, restore the invariant. */
     if (num_bits == width * full_height) {
         porder->height = full_height;
         porder->shift = 0;
     }
-    gx_ht_construct_bits(porder);
 }
 
 /* Construct a single offset/mask. */
@@ -428,6 +428,12 @@ void gs_lib_ctx_fin(gs_memory_t *mem)
 #ifdef WITH_CAL
         cal_fin(ctx->core->cal_ctx, ctx->core->memory);
 #endif
+        if (ctx->core->ht_order_cache != NULL)
+            ctx->core->ht_order_cache_free(ctx->core->memory,
+                                           ctx->core->ht_order_cache);
+        if (ctx->core->stroke_cache != NULL)
+            ctx->core->stroke_cache_free(ctx->core->memory,
+                                         ctx->core->stroke_cache);
         gs_purge_control_paths(ctx->core->memory, gs_permit_file_reading);
         gs_purge_control_paths(ctx->core->memory, gs_permit_file_writing);
         gs_purge_control_paths(ctx->core->memory, gs_permit_file_control);
@@ -104,6 +104,8 @@ typedef struct {
      * for the clist based devices. */
     bool CPSI_mode;
     int scanconverter;
+    int scanconverter_threads; /* Worker threads for huge fills, 0 = none */
+    int image_threads;         /* Worker threads for wide image rows, 0 = none */
     int act_on_uel;
 
     int path_control_active;
@@ -115,6 +117,15 @@ typedef struct {
      * but that's too hard to arrange, so we live with it in
      * all builds. */
     void *cal_ctx;
+    /* Cache of constructed halftone spot orders (see gsht.c), shared
+     * by every context using this core. It is created on first use by
+     * the graphics library, which also supplies the function to free
+     * it, so that the core does not depend on the halftone code. */
+    void *ht_order_cache;
+    void (*ht_order_cache_free)(gs_memory_t *mem, void *cache);
+    /* Likewise the cache of stroke outlines (see gxstroke.c). */
+    void *stroke_cache;
+    void (*stroke_cache_free)(gs_memory_t *mem, void *cache);
 
     /* Stashed args */
     int arg_max;
@@ -170,6 +181,9 @@ enum {
     GS_SCANCONVERTER_OLD = 0,
     GS_SCANCONVERTER_DEFAULT = 1,
     GS_SCANCONVERTER_EDGEBUFFER = 2,
+    /* As EDGEBUFFER, but anti-aliased fills and strokes on memory devices
+     * are rendered with analytic coverage rather than the alpha buffer. */
+    GS_SCANCONVERTER_ANALYTIC = 3,
 
     /* And finally a flag to let us know which is the default */
     GS_SCANCONVERTER_DEFAULT_IS_EDGEBUFFER = 1
@@ -271,6 +271,22 @@ alpha_buffer_release(gs_gstate * pgs, bool newpath)
     return code;
 }
 
+/* Can an anti-aliased fill in the current color be rendered with analytic
+   coverage (straight onto the device) instead of through an alpha buffer?
+   Only if asked for, and only for pure colors on chunky 8/24/32 bit
+   memory devices, whose copy_alpha takes 8 bit alpha. */
+static bool
+analytic_aa_usable(gs_gstate * pgs, bool devn)
+{
+    gx_device *dev = gs_currentdevice_inline(pgs);
+    int depth = dev->color_info.depth;
+
+    return !devn &&
+           gs_getscanconverter(pgs->memory) == GS_SCANCONVERTER_ANALYTIC &&
+           (depth == 8 || depth == 24 || depth == 32) && !dev->is_planar &&
+           lop_is_idempotent(pgs->log_op) && gs_device_is_memory(dev);
+}
+
 static int do_fill(gs_gstate *pgs, int rule)
 {
     int code, abits, acode, rcode = 0;
@@ -310,6 +326,9 @@ static int do_fill(gs_gstate *pgs, int rule)
         if (color_is_pure(col) || devn)
             abits = alpha_buffer_bits(pgs);
     }
+    if (abits > 1 && analytic_aa_usable(pgs, devn))
+        return gx_fill_path_analytic_aa(pgs->path, gs_currentdevicecolor_inline(pgs),
+                                        pgs, rule);
     if (abits > 1) {
         acode = alpha_buffer_init(pgs, pgs->fill_adjust.x,
                                   pgs->fill_adjust.y, abits, devn);
@@ -429,18 +448,39 @@ do_stroke(gs_gstate * pgs)
                 float2fixed(max(xxyy, xyyx) * new_width / 2);
         float orig_flatness = gs_currentflat(pgs);
         gx_path spath;
+        bool analytic = false;
+        int log2_scale = ilog2(abits);
+        gx_device_memory sdev;
 
         /* Scale up the line width, dash pattern, and flatness. */
         if (extra_adjust < fixed_1)
             extra_adjust = fixed_1;
-        acode = alpha_buffer_init(pgs,
-                                  pgs->fill_adjust.x + extra_adjust,
-                                  pgs->fill_adjust.y + extra_adjust,
-                                  abits, devn);
-        if (acode == 2) /* Special code meaning no fill required */
-            return 0;
-        if (acode < 0)
-            return acode;
+        if (analytic_aa_usable(pgs, devn) && max(xxyy, xyyx) * orig_width >= 1.0) {
+            /*
+             * Stroke exactly as we would into the alpha buffer: at its
+             * scale, and against a memory device standing in for it, as
+             * the joins of the outline depend on whether the device's
+             * initial matrix is reflected. Then fill the outline at
+             * device resolution with analytic coverage. Lines under a
+             * pixel wide still go through the alpha buffer, which gives
+             * zero width lines some ink.
+             */
+            gx_device_init_on_stack((gx_device *)&sdev,
+                                    (const gx_device *)gdev_mem_device_for_bits(1),
+                                    pgs->memory);
+            scale_paths(pgs, log2_scale, log2_scale, true);
+            analytic = true;
+            acode = 0;
+        } else {
+            acode = alpha_buffer_init(pgs,
+                                      pgs->fill_adjust.x + extra_adjust,
+                                      pgs->fill_adjust.y + extra_adjust,
+                                      abits, devn);
+            if (acode == 2) /* Special code meaning no fill required */
+                return 0;
+            if (acode < 0)
+                return acode;
+        }
         gs_setlinewidth(pgs, new_width);
         scale_dash_pattern(pgs, scale);
         gs_setflat(pgs, orig_flatness * scale);
@@ -449,15 +489,27 @@ do_stroke(gs_gstate * pgs)
          * entire path as a single unit.
          */
         gx_path_init_local(&spath, pgs->memory);
-        code = gx_stroke_add(pgs->path, &spath, pgs, false);
+        if (analytic)
+            code = gx_gstate_stroke_add(pgs->path, &spath, (gx_device *)&sdev, pgs);
+        else
+            code = gx_stroke_add(pgs->path, &spath, pgs, false);
         gs_setlinewidth(pgs, orig_width);
         scale_dash_pattern(pgs, 1.0 / scale);
-        if (code >= 0)
-            code = gx_fill_path(&spath, gs_currentdevicecolor_inline(pgs), pgs,
-                                gx_rule_winding_number,
-                                pgs->fill_adjust.x,
-                                pgs->fill_adjust.y);
-        gs_setflat(pgs, orig_flatness);
+        if (analytic) {
+            scale_paths(pgs, -log2_scale, -log2_scale, true);
+            gs_setflat(pgs, orig_flatness);
+            gx_path_scale_exp2_shared(&spath, -log2_scale, -log2_scale, false);
+            if (code >= 0)
+                code = gx_fill_path_analytic_aa(&spath, gs_currentdevicecolor_inline(pgs),
+                                                pgs, gx_rule_winding_number);
+        } else {
+            if (code >= 0)
+                code = gx_fill_path(&spath, gs_currentdevicecolor_inline(pgs), pgs,
+                                    gx_rule_winding_number,
+                                    pgs->fill_adjust.x,
+                                    pgs->fill_adjust.y);
+            gs_setflat(pgs, orig_flatness);
+        }
         gx_path_free(&spath, "gs_stroke");
         if (acode > 0)
             rcode = alpha_buffer_release(pgs, code >= 0);
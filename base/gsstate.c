@@ -769,6 +769,42 @@ gs_getscanconverter(const gs_memory_t * mem)
     return libctx->core->scanconverter;
 }
 
+/* setscanconverterthreads */
+void
+gs_setscanconverterthreads(gs_gstate * gs, int threads)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(gs->memory);
+
+    libctx->core->scanconverter_threads = threads < 0 ? 0 : threads;
+}
+
+/* getscanconverterthreads */
+int
+gs_getscanconverterthreads(const gs_memory_t * mem)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return libctx->core->scanconverter_threads;
+}
+
+/* setimagethreads */
+void
+gs_setimagethreads(gs_gstate * gs, int threads)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(gs->memory);
+
+    libctx->core->image_threads = threads < 0 ? 0 : threads;
+}
+
+/* getimagethreads */
+int
+gs_getimagethreads(const gs_memory_t * mem)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return libctx->core->image_threads;
+}
+
 /* setrenderingintent
  *
  *  Use ICC numbers from Table 18 (section 6.1.11) rather than the PDF order
@@ -105,6 +105,8 @@ typedef struct gs_transparency_mask_params_s {
     int (*TransferFunction)(double in, float *out, void *proc_data);
     gs_function_t *TransferFunction_data;
     bool replacing;
+    gs_id cache_id;     /* Identifies the mask's content for reuse, 0 if none */
+    const gs_gstate *cache_gstate;  /* State the content is drawn in, if not the current one */
     int64_t icc_hashcode;                    /* Needed when we are doing clist reading */
     cmm_profile_t *iccprofile;               /* The profile  */
 } gs_transparency_mask_params_t;
@@ -125,6 +127,9 @@ typedef struct gx_transparency_mask_params_s {
     bool idle;
     bool replacing;
     uint mask_id;
+    gs_id cache_id;
+    gs_id cache_clip_id;        /* Id of a clip that cuts into the mask, or 0 */
+    int64_t cache_state;        /* Hash of the state the content inherits */
     byte transfer_fn[MASK_TRANSFER_FUNCTION_SIZE*2+2];
     int64_t icc_hashcode;                    /* Needed when we are doing clist reading */
     cmm_profile_t *iccprofile;               /* The profile  */
@@ -143,6 +148,9 @@ typedef struct gx_transparency_mask_params_s {
              5 /* group color, replacing, function_is_identity, Background_components, Matte_components */ + \
              sizeof(((gs_pdf14trans_params_t *)0)->bbox) + \
              sizeof(((gs_pdf14trans_params_t *)0)->mask_id) + \
+             sizeof(((gs_pdf14trans_params_t *)0)->cache_id) + \
+             sizeof(((gs_pdf14trans_params_t *)0)->cache_clip_id) + \
+             sizeof(((gs_pdf14trans_params_t *)0)->cache_state) + \
              sizeof(((gs_pdf14trans_params_t *)0)->Background) + \
              sizeof(((gs_pdf14trans_params_t *)0)->Matte) + \
              sizeof(float)*4 + /* If cmyk background */ \
@@ -22,6 +22,7 @@
 #include "gstrans.h"
 #include "gsutil.h"
 #include "gzstate.h"
+#include "gzcpath.h"
 #include "gxdevcli.h"
 #include "gdevdevn.h"
 #include "gxblend.h"
@@ -30,6 +31,11 @@
 #include "gxarith.h"
 #include "gxclist.h"
 #include "gsicc_manage.h"
+#include "gsicc_cache.h"
+#include "gsmd5.h"
+#include "gxfont.h"
+#include "gxdht.h"
+#include "gscie.h"
 
 /* ------ Transparency-related graphics state elements ------ */
 
@@ -540,9 +546,128 @@ gs_trans_mask_params_init(gs_transparency_mask_params_t *ptmp,
     ptmp->TransferFunction = mask_transfer_identity;
     ptmp->TransferFunction_data = 0;
     ptmp->replacing = false;
+    ptmp->cache_id = 0;
+    ptmp->cache_gstate = NULL;
     ptmp->iccprofile = NULL;
 }
 
+/* Add a colour to the hash of a cached mask's state. A new device or ICC
+   space is made by every setcolorspace, so those are known by their
+   profile; any other space only matches itself. Pattern colours aren't
+   captured, so return false for them. */
+static bool
+trans_mask_hash_color(gs_md5_state_t *md5, const gs_gstate_color *pcolor)
+{
+    const gs_color_space *pcs = pcolor->color_space;
+    gs_color_space_index index;
+    int64_t key;
+    int n;
+
+    if (pcs == NULL || pcolor->ccolor == NULL)
+        return false;
+    index = gs_color_space_get_index(pcs);
+    if (index == gs_color_space_index_Pattern)
+        return false;
+    n = gs_color_space_num_components(pcs);
+    if (n < 0 || n > GS_CLIENT_COLOR_MAX_COMPONENTS)
+        return false;
+    if (index == gs_color_space_index_ICC && pcs->cmm_icc_profile_data != NULL)
+        key = gsicc_get_hash(pcs->cmm_icc_profile_data);
+    else
+        key = pcs->id;
+    gs_md5_append(md5, (const gs_md5_byte_t *)&index, sizeof(index));
+    gs_md5_append(md5, (const gs_md5_byte_t *)&key, sizeof(key));
+    gs_md5_append(md5, (const gs_md5_byte_t *)pcolor->ccolor->paint.values,
+                  n * sizeof(pcolor->ccolor->paint.values[0]));
+    return true;
+}
+
+/*
+ * A cached mask (see cache_id) can only be reused if its content inherits
+ * the same state: that of pdgs, the gstate it is drawn in, bar what the
+ * group sets afresh (path, transparency parameters, fill colour) and the
+ * CTM and clip, which are compared separately. If the group has no colour
+ * space of its own the content also inherits the current fill colour of
+ * pgs. Returns false if the state can't be captured.
+ */
+static bool
+trans_mask_state_hash(const gs_gstate *pdgs, const gs_gstate *pgs,
+                      bool inherit_color, int64_t *phash)
+{
+    const gx_line_params *plp = &pdgs->line_params;
+    gs_md5_state_t md5;
+    gs_md5_byte_t digest[16];
+    gs_id ids[11];
+    int64_t word1 = 0, word2 = 0;
+    int k;
+
+#define HASH_VALUE(v) gs_md5_append(&md5, (const gs_md5_byte_t *)&(v), sizeof(v))
+    gs_md5_init(&md5);
+    HASH_VALUE(plp->half_width);
+    HASH_VALUE(plp->start_cap);
+    HASH_VALUE(plp->end_cap);
+    HASH_VALUE(plp->dash_cap);
+    HASH_VALUE(plp->join);
+    HASH_VALUE(plp->curve_join);
+    HASH_VALUE(plp->miter_limit);
+    HASH_VALUE(plp->dot_length);
+    HASH_VALUE(plp->dot_length_absolute);
+    HASH_VALUE(plp->dot_orientation);
+    HASH_VALUE(plp->dash.pattern_size);
+    HASH_VALUE(plp->dash.offset);
+    HASH_VALUE(plp->dash.adapt);
+    if (plp->dash.pattern_size != 0)
+        gs_md5_append(&md5, (const gs_md5_byte_t *)plp->dash.pattern,
+                      plp->dash.pattern_size * sizeof(plp->dash.pattern[0]));
+    HASH_VALUE(pdgs->log_op);
+    HASH_VALUE(pdgs->clamp_coordinates);
+    HASH_VALUE(pdgs->text_knockout);
+    HASH_VALUE(pdgs->text_rendering_mode);
+    HASH_VALUE(pdgs->overprint);
+    HASH_VALUE(pdgs->overprint_mode);
+    HASH_VALUE(pdgs->stroke_overprint);
+    HASH_VALUE(pdgs->flatness);
+    HASH_VALUE(pdgs->fill_adjust);
+    HASH_VALUE(pdgs->stroke_adjust);
+    HASH_VALUE(pdgs->accurate_curves);
+    HASH_VALUE(pdgs->smoothness);
+    HASH_VALUE(pdgs->renderingintent);
+    HASH_VALUE(pdgs->blackptcomp);
+    HASH_VALUE(pdgs->screen_phase);
+    HASH_VALUE(pdgs->alphaisshape);
+    HASH_VALUE(pdgs->textspacing);
+    HASH_VALUE(pdgs->textleading);
+    HASH_VALUE(pdgs->textrise);
+    HASH_VALUE(pdgs->wordspacing);
+    HASH_VALUE(pdgs->texthscaling);
+    HASH_VALUE(pdgs->PDFfontsize);
+    ids[0] = pdgs->font != NULL ? pdgs->font->id : 0;
+    ids[1] = pdgs->root_font != NULL ? pdgs->root_font->id : 0;
+    ids[2] = pdgs->dev_ht != NULL ? pdgs->dev_ht->id : 0;
+    ids[3] = pdgs->cie_render != NULL ? pdgs->cie_render->id : 0;
+    ids[4] = pdgs->black_generation != NULL ? pdgs->black_generation->id : 0;
+    ids[5] = pdgs->undercolor_removal != NULL ? pdgs->undercolor_removal->id : 0;
+    ids[6] = pdgs->set_transfer.red != NULL ? pdgs->set_transfer.red->id : 0;
+    ids[7] = pdgs->set_transfer.green != NULL ? pdgs->set_transfer.green->id : 0;
+    ids[8] = pdgs->set_transfer.blue != NULL ? pdgs->set_transfer.blue->id : 0;
+    ids[9] = pdgs->set_transfer.gray != NULL ? pdgs->set_transfer.gray->id : 0;
+    ids[10] = pdgs->view_clip != NULL ? pdgs->view_clip->id : 0;
+    HASH_VALUE(ids);
+#undef HASH_VALUE
+    if (!trans_mask_hash_color(&md5, &pdgs->color[1]))
+        return false;
+    if (inherit_color && !trans_mask_hash_color(&md5, &pgs->color[0]))
+        return false;
+    gs_md5_finish(&md5, digest);
+    /* Fold the digest into 64 bits, as gsicc does for profiles */
+    for (k = 0; k < 8; k++) {
+        word1 += ((int64_t)digest[k]) << (k * 8);
+        word2 += ((int64_t)digest[k + 8]) << (k * 8);
+    }
+    *phash = word1 ^ word2;
+    return true;
+}
+
 int
 gs_begin_transparency_mask(gs_gstate * pgs,
                            const gs_transparency_mask_params_t * ptmp,
@@ -574,6 +699,30 @@ gs_begin_transparency_mask(gs_gstate * pgs,
             (ptmp->TransferFunction == mask_transfer_identity);
     params.mask_is_image = mask_is_image;
     params.replacing = ptmp->replacing;
+    params.cache_id = ptmp->cache_id;
+    if (params.cache_id != 0) {
+        /* A cached mask can only be reused with the same inherited state
+           and under the same clip, unless the clip leaves the whole mask
+           alone. The content is drawn in cache_gstate, if given. */
+        const gs_gstate *pdgs = ptmp->cache_gstate != NULL ? ptmp->cache_gstate : pgs;
+        gs_rect dbox;
+        gs_fixed_rect fbox;
+
+        if (!trans_mask_state_hash(pdgs, pgs, ptmp->ColorSpace == NULL,
+                                   &params.cache_state))
+            params.cache_id = 0;
+        code = gs_bbox_transform(pbbox, &ctm_only(pgs), &dbox);
+        if (code < 0)
+            return code;
+        if (pdgs->clip_path != NULL &&
+            (set_float2fixed_vars(fbox.p.x, dbox.p.x - 1) < 0 ||
+             set_float2fixed_vars(fbox.p.y, dbox.p.y - 1) < 0 ||
+             set_float2fixed_vars(fbox.q.x, dbox.q.x + 1) < 0 ||
+             set_float2fixed_vars(fbox.q.y, dbox.q.y + 1) < 0 ||
+             !gx_cpath_includes_rectangle(pdgs->clip_path, fbox.p.x, fbox.p.y,
+                                          fbox.q.x, fbox.q.y)))
+            params.cache_clip_id = pdgs->clip_path->id;
+    }
 
     /* The eventual state that we want this smask to be moved to
        is always gray.  This should provide us with a significant
@@ -681,6 +830,9 @@ gx_begin_transparency_mask(gs_gstate * pgs, gx_device * pdev,
     tmp.idle = pparams->idle;
     tmp.replacing = pparams->replacing;
     tmp.mask_id = pparams->mask_id;
+    tmp.cache_id = pparams->cache_id;
+    tmp.cache_clip_id = pparams->cache_clip_id;
+    tmp.cache_state = pparams->cache_state;
 
     if (tmp.group_color == ICC ) {
         /* Do I need to ref count here? */
@@ -130,6 +130,9 @@ struct gs_pdf14trans_params_s {
     bool effective_overprint_mode;
     bool idle; /* For clist reader.*/
     uint mask_id; /* For clist reader.*/
+    gs_id cache_id; /* Soft mask content, see gs_transparency_mask_params_t */
+    gs_id cache_clip_id; /* Clip that cuts into a cached mask, 0 if none */
+    int64_t cache_state; /* State inherited by a cached mask's content */
     int group_color_numcomps;
     gs_transparency_color_t group_color;
     int64_t icc_hash;
@@ -137,6 +140,7 @@ struct gs_pdf14trans_params_s {
     bool crop_blend_params;  /* This is used when the blend params are updated
                                 during a transparency group push */
     bool is_pattern;      /* Needed to detect device push and pop for clist pattern */
+    gs_int_rect page_rect;  /* For clist reader: area to composite, empty for all */
 };
 
 /*
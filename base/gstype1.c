@@ -40,6 +40,101 @@
  */
 #define ALWAYS_DO_FLEX_AS_CURVE 0
 
+/*
+ * Outline tapes (see gxtype1.h) record the hinter calls made by a
+ * charstring after its hsbw/sbw as an opcode followed by its operands.
+ * A charstring is recorded only if it is interpreted in one piece: any
+ * exit to the client (unknown OtherSubrs, pop), seac, Multiple Master
+ * blending or a second hsbw/sbw abandons the tape.  setcurrentpoint, which
+ * ends every Flex, is recorded without the origin offset of replaced
+ * metrics, since that is only known once the hsbw/sbw has run.
+ */
+typedef enum {
+    t1_tape_hstem,
+    t1_tape_vstem,
+    t1_tape_hstem3,
+    t1_tape_vstem3,
+    t1_tape_rmoveto,
+    t1_tape_rlineto,
+    t1_tape_rcurveto,
+    t1_tape_closepath,
+    t1_tape_dotsection,
+    t1_tape_flex_beg,
+    t1_tape_flex_point,
+    t1_tape_flex_end,
+    t1_tape_drop_hints,
+    t1_tape_setcurrentpoint
+} t1_tape_op;
+
+/* Replay a tape into the hinter. */
+static int
+type1_replay_tape(t1_hinter *h, const gs_fixed_point *origin_offset,
+                  const fixed *tape, int length)
+{
+    const fixed *p = tape, *end = tape + length;
+    int code = 0;
+
+    while (p < end && code >= 0) {
+        switch ((t1_tape_op)*p++) {
+            case t1_tape_hstem:
+                code = t1_hinter__hstem(h, p[0], p[1]);
+                p += 2;
+                break;
+            case t1_tape_vstem:
+                code = t1_hinter__vstem(h, p[0], p[1]);
+                p += 2;
+                break;
+            case t1_tape_hstem3:
+                code = t1_hinter__hstem3(h, p[0], p[1], p[2], p[3], p[4], p[5]);
+                p += 6;
+                break;
+            case t1_tape_vstem3:
+                code = t1_hinter__vstem3(h, p[0], p[1], p[2], p[3], p[4], p[5]);
+                p += 6;
+                break;
+            case t1_tape_rmoveto:
+                code = t1_hinter__rmoveto(h, p[0], p[1]);
+                p += 2;
+                break;
+            case t1_tape_rlineto:
+                code = t1_hinter__rlineto(h, p[0], p[1]);
+                p += 2;
+                break;
+            case t1_tape_rcurveto:
+                code = t1_hinter__rcurveto(h, p[0], p[1], p[2], p[3], p[4], p[5]);
+                p += 6;
+                break;
+            case t1_tape_closepath:
+                code = t1_hinter__closepath(h);
+                break;
+            case t1_tape_dotsection:
+                code = t1_hinter__dotsection(h);
+                break;
+            case t1_tape_flex_beg:
+                code = t1_hinter__flex_beg(h);
+                break;
+            case t1_tape_flex_point:
+                code = t1_hinter__flex_point(h);
+                break;
+            case t1_tape_flex_end:
+                code = t1_hinter__flex_end(h, p[0]);
+                p += 1;
+                break;
+            case t1_tape_drop_hints:
+                code = t1_hinter__drop_hints(h);
+                break;
+            case t1_tape_setcurrentpoint:
+                t1_hinter__setcurrentpoint(h, p[0] + origin_offset->x,
+                                           p[1] + origin_offset->y);
+                p += 2;
+                break;
+            default:
+                return_error(gs_error_unregistered);
+        }
+    }
+    return code;
+}
+
 /* ------ Interpreter subroutines ------ */
 
 /*
@@ -126,11 +221,30 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
 #define ics5 fixed2int_var(cs5)
     cs_ptr csp;
 #define clear CLEAR_CSTACK(cstack, csp)
+#define TAPE_ROOM(n)\
+  (tape_length >= 0 &&\
+   (tape_length + (n) < type1_outline_tape_max || (tape_length = -1, 0)))
+#define TAPE_OP(op)\
+  BEGIN if (TAPE_ROOM(1)) tape[tape_length++] = (fixed)(op); END
+#define TAPE_OP1(op, a)\
+  BEGIN if (TAPE_ROOM(2)) tape[tape_length++] = (fixed)(op),\
+    tape[tape_length++] = (a); END
+#define TAPE_OP2(op, a, b)\
+  BEGIN if (TAPE_ROOM(3)) tape[tape_length++] = (fixed)(op),\
+    tape[tape_length++] = (a), tape[tape_length++] = (b); END
+#define TAPE_OP6(op, a, b, c, d, e, f)\
+  BEGIN if (TAPE_ROOM(7)) tape[tape_length++] = (fixed)(op),\
+    tape[tape_length++] = (a), tape[tape_length++] = (b),\
+    tape[tape_length++] = (c), tape[tape_length++] = (d),\
+    tape[tape_length++] = (e), tape[tape_length++] = (f); END
     ip_state_t *ipsp = &pcis->ipstack[pcis->ips_count - 1];
     const byte *cip, *cipend;
     crypt_state state;
     register int c;
     int code = 0;
+    fixed tape[type1_outline_tape_max];
+    int tape_length = -1;	/* < 0 if not recording */
+    uint tape_ip = 0;
 
     switch (pcis->init_done) {
         case -1:
@@ -151,6 +265,33 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                             pcis->pfont->is_resource);
             if (code < 0)
                 return code;
+            /*
+             * If we're about to continue a charstring right after its
+             * hsbw/sbw, replay a recorded outline or start recording one.
+             */
+            if (pgd == 0 && pcis->ips_count == 1 && pcis->os_count == 0 &&
+                pcis->seac_accent < 0 && !pcis->seac_flag &&
+                pcis->ignore_pops == 0 && ipsp->ip != 0) {
+                const fixed *ptape;
+                int length;
+
+                tape_ip = ipsp->ip - ipsp->cs_data.bits.data;
+                if (gs_type1_outline_lookup(pfont, &ipsp->cs_data.bits,
+                                            tape_ip, &ptape, &length) > 0) {
+                    code = type1_replay_tape(h, &pcis->origin_offset,
+                                             ptape, length);
+                    if (code < 0)
+                        return code;
+                    code = t1_hinter__endglyph(h);
+                    if (code < 0)
+                        return code;
+                    code = gx_setcurrentpoint_from_path(pcis->pgs, pcis->path);
+                    if (code < 0)
+                        return code;
+                    return gs_type1_endchar(pcis);
+                }
+                tape_length = 0;
+            }
             break;
         default /*case 1 */ :
             break;
@@ -262,11 +403,13 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                 /* in Type 1 and Type 2 charstrings. */
 
             case cx_hstem:
+                TAPE_OP2(t1_tape_hstem, cs0, cs1);
                 code = t1_hinter__hstem(h, cs0, cs1);
                 if (code < 0)
                     return code;
                 cnext;
             case cx_vstem:
+                TAPE_OP2(t1_tape_vstem, cs0, cs1);
                 code = t1_hinter__vstem(h, cs0, cs1);
                 if (code < 0)
                     return code;
@@ -275,10 +418,12 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                 cs1 = cs0;
                 cs0 = 0;
               move:		/* cs0 = dx, cs1 = dy for hint checking. */
+                TAPE_OP2(t1_tape_rmoveto, cs0, cs1);
                 code = t1_hinter__rmoveto(h, cs0, cs1);
                 goto cc;
             case cx_rlineto:
               line:		/* cs0 = dx, cs1 = dy for hint checking. */
+                TAPE_OP2(t1_tape_rlineto, cs0, cs1);
                 code = t1_hinter__rlineto(h, cs0, cs1);
               cc:if (code < 0)
                     return code;
@@ -291,6 +436,7 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                 cs0 = 0;
                 goto line;
             case cx_rrcurveto:
+                TAPE_OP6(t1_tape_rcurveto, cs0, cs1, cs2, cs3, cs4, cs5);
                 code = t1_hinter__rcurveto(h, cs0, cs1, cs2, cs3, cs4, cs5);
                 goto cc;
             case cx_endchar:
@@ -317,6 +463,9 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                     code = gx_setcurrentpoint_from_path(pcis->pgs, pcis->path);
                     if (code < 0)
                         return code;
+                    if (tape_length >= 0)
+                        gs_type1_outline_store(pfont, &pcis->ipstack[0].cs_data.bits,
+                                               tape_ip, tape, tape_length);
                 } else {
                     code = t1_hinter__end_subglyph(h);
                     if (code < 0)
@@ -338,9 +487,11 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                 cs1 = 0;
                 goto move;
             case cx_vhcurveto:
+                TAPE_OP6(t1_tape_rcurveto, 0, cs0, cs1, cs2, cs3, 0);
                 code = t1_hinter__rcurveto(h, 0, cs0, cs1, cs2, cs3, 0);
                 goto cc;
             case cx_hvcurveto:
+                TAPE_OP6(t1_tape_rcurveto, cs0, 0, cs1, cs2, 0, cs3);
                 code = t1_hinter__rcurveto(h, cs0, 0, cs1, cs2, 0, cs3);
                 goto cc;
 
@@ -348,9 +499,11 @@ gs_type1_interpret(gs_type1_state * pcis, const gs_glyph_data_t *pgd,
                 /* plus 'escape'. */
 
             case c1_closepath:
+                TAPE_OP(t1_tape_closepath);
                 code = t1_hinter__closepath(h);
                 goto cc;
             case c1_hsbw:
+                tape_length = -1;
                 if (!pcis->seac_flag) {
                     fixed sbx = cs0, sby = fixed_0, wx = cs1, wy = fixed_0;
 
@@ -409,21 +562,25 @@ rsbw:		/* Give the caller the opportunity to intervene. */
 #endif
                 switch ((char1_extended_command) c) {
                     case ce1_dotsection:
+                        TAPE_OP(t1_tape_dotsection);
                         code = t1_hinter__dotsection(h);
                         if (code < 0)
                             return code;
                         cnext;
                     case ce1_vstem3:
+                        TAPE_OP6(t1_tape_vstem3, cs0, cs1, cs2, cs3, cs4, cs5);
                         code = t1_hinter__vstem3(h, cs0, cs1, cs2, cs3, cs4, cs5);
                         if (code < 0)
                             return code;
                         cnext;
                     case ce1_hstem3:
+                        TAPE_OP6(t1_tape_hstem3, cs0, cs1, cs2, cs3, cs4, cs5);
                         code = t1_hinter__hstem3(h, cs0, cs1, cs2, cs3, cs4, cs5);
                         if (code < 0)
                             return code;
                         cnext;
                     case ce1_seac:
+                        tape_length = -1;
                         code = gs_type1_seac(pcis, cstack + 1, cstack[0],
                                              ipsp);
                         if (code != 0) {
@@ -435,6 +592,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                         cipend = ipsp->cs_data.bits.data + ipsp->cs_data.bits.size;
                         goto call;
                     case ce1_sbw:
+                        tape_length = -1;
                         if (!pcis->seac_flag)
                             code = t1_hinter__sbw(h, cs0, cs1, cs2, cs3);
                         else
@@ -472,6 +630,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                                         csp[-4] = csp[-3] - pcis->asb_diff;
                                         csp[-3] = csp[-2];
                                         csp -= 3;
+                                        TAPE_OP1(t1_tape_flex_end, fheight);
                                         code = t1_hinter__flex_end(h, fheight);
                                     }
                                     if (code < 0)
@@ -480,6 +639,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                                     inext;
                                 case 1:
                                     CS_CHECK_POP(csp, cstack);
+                                    TAPE_OP(t1_tape_flex_beg);
                                     code = t1_hinter__flex_beg(h);
                                     if (code < 0)
                                         return code;
@@ -490,6 +650,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                                     CS_CHECK_POP(csp, cstack);
                                     if (pcis->flex_count >= flex_max)
                                         return_error(gs_error_invalidfont);
+                                    TAPE_OP(t1_tape_flex_point);
                                     code = t1_hinter__flex_point(h);
                                     if (code < 0)
                                         return code;
@@ -501,6 +662,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                                     /* See above as to why we don't just */
                                     /* look ahead in the opcode stream. */
                                     pcis->ignore_pops = 1;
+                                    TAPE_OP(t1_tape_drop_hints);
                                     code = t1_hinter__drop_hints(h);
                                     if (code < 0)
                                         return code;
@@ -513,6 +675,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                                 case 14:
                                     num_results = 1;
                                   blend:
+                                    tape_length = -1;
                                     code = gs_type1_blend(pcis, csp,
                                                           num_results);
                                     if (code < 0)
@@ -569,6 +732,7 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                             pcis->ignore_pops--;
                             inext;
                         }
+                        tape_length = -1;
                         CS_CHECK_PUSH(csp, cstack);
                         ++csp;
                         code = (*pdata->procs.pop_value)
@@ -577,8 +741,11 @@ rsbw:		/* Give the caller the opportunity to intervene. */
                             return_error(code);
                         goto pushed;
                     case ce1_setcurrentpoint:
-                        cs0 += pcis->adxy.x + pcis->origin_offset.x;
-                        cs1 += pcis->adxy.y + pcis->origin_offset.y;
+                        cs0 += pcis->adxy.x;
+                        cs1 += pcis->adxy.y;
+                        TAPE_OP2(t1_tape_setcurrentpoint, cs0, cs1);
+                        cs0 += pcis->origin_offset.x;
+                        cs1 += pcis->origin_offset.y;
                         t1_hinter__setcurrentpoint(h, cs0, cs1);
                         cnext;
                     default:
@@ -41,6 +41,8 @@ typedef struct gx_colors_usage_s {
                                 /* executed plane-by-plane on CMYK devices */
     gs_int_rect trans_bbox;	/* transparency bbox allows skipping the pdf14 compositor for some bands */
                                 /* coordinates are band relative, 0 <= p.y < page_band_height */
+    bool trans_pattern;		/* true if a pattern with transparency is used, */
+                                /* so the band can't be drawn without pdf14 at all */
 } gx_color_usage_t;
 
 /*
@@ -30,6 +30,14 @@
 #include "cal.h"
 #endif
 
+/* The plane kernels used for the commonest group compositions have wider
+   versions for x86, compiled for their own instruction set only (via the
+   target attribute) and selected at run time if the CPU supports them. */
+#if defined(HAVE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPOSE_PLANE_SIMD
+#include <immintrin.h>
+#endif
+
 typedef int art_s32;
 
 #if RAW_DUMP
@@ -365,23 +373,17 @@ smask_blend(byte *gs_restrict src, int width, int height, int rowstride,
             }
         }
     } else {
-        byte comp, a;
-        int tmp;
-        const byte bg = 0;
         for (y = 0; y < height; y++) {
-            position = y * rowstride;
+            byte *gs_restrict comp = src + y * rowstride;
+            const byte *gs_restrict a = comp + planestride;
+
+            /* Blend towards the (zero) background. The rounding makes
+               this exact for a == 0 and a == 0xff as well, so the loop
+               needs no branches and can be vectorized. */
             for (x = 0; x < width; x++) {
-                a = src[position + planestride];
-                if ((a + 1) & 0xfe) {
-                    a ^= 0xff;
-                    comp  = src[position];
-                    tmp = ((bg - comp) * a) + 0x80;
-                    comp += (tmp + (tmp >> 8)) >> 8;
-                    src[position] = comp;
-                } else if (a == 0) {
-                    src[position] = 0;
-                }
-                position+=1;
+                int tmp = 0x80 - comp[x] * (a[x] ^ 0xff);
+
+                comp[x] += (tmp + (tmp >> 8)) >> 8;
             }
         }
     }
@@ -3071,6 +3073,109 @@ compose_group_nonknockout_blend(byte *tos_ptr, bool tos_isolated, int tos_planes
         backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0, y0, x1, y1, pblend_procs, pdev, 1);
 }
 
+/*
+ * The commonest group compositions (Normal blend mode, isolated, nothing
+ * but colour and alpha planes) are done in two passes over each row.
+ * The first pass works out the resulting alpha of each pixel, and the
+ * 16.16 weight of the source colour: 0 leaves the backdrop alone and
+ * 0x10000 copies the source. The second pass applies the weights to each
+ * colour plane in turn, which is a straight vector loop over the planar
+ * data. The arithmetic is exactly that of art_pdf_composite_pixel_alpha_8.
+ */
+#define COMPOSE_CHUNK 256
+
+typedef void (*compose_plane_8_fn)(byte *gs_restrict nos,
+                                   const byte *gs_restrict tos,
+                                   const int *gs_restrict scale, int n);
+
+static void
+compose_plane_8(byte *gs_restrict nos, const byte *gs_restrict tos,
+                const int *gs_restrict scale, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        int c_b = nos[i];
+
+        nos[i] = c_b + ((scale[i] * (tos[i] - c_b) + 0x8000) >> 16);
+    }
+}
+
+#ifdef COMPOSE_PLANE_SIMD
+__attribute__((target("sse4.1")))
+static void
+compose_plane_8_SSE41(byte *gs_restrict nos, const byte *gs_restrict tos,
+                      const int *gs_restrict scale, int n)
+{
+    const __m128i round = _mm_set1_epi32(0x8000);
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        int b, s;
+        __m128i c_b, c_s, t;
+
+        memcpy(&b, nos + i, 4);
+        memcpy(&s, tos + i, 4);
+        c_b = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(b));
+        c_s = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(s));
+        t = _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(scale + i)),
+                            _mm_sub_epi32(c_s, c_b));
+        t = _mm_add_epi32(c_b, _mm_srai_epi32(_mm_add_epi32(t, round), 16));
+        t = _mm_packus_epi32(t, t);
+        b = _mm_cvtsi128_si32(_mm_packus_epi16(t, t));
+        memcpy(nos + i, &b, 4);
+    }
+    compose_plane_8(nos + i, tos + i, scale + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void
+compose_plane_8_AVX2(byte *gs_restrict nos, const byte *gs_restrict tos,
+                     const int *gs_restrict scale, int n)
+{
+    const __m256i round = _mm256_set1_epi32(0x8000);
+    int i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256i c_b, c_s, t;
+        __m128i r;
+
+        c_b = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(nos + i)));
+        c_s = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(tos + i)));
+        t = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i *)(scale + i)),
+                               _mm256_sub_epi32(c_s, c_b));
+        t = _mm256_add_epi32(c_b,
+                             _mm256_srai_epi32(_mm256_add_epi32(t, round), 16));
+        r = _mm_packus_epi32(_mm256_castsi256_si128(t),
+                             _mm256_extracti128_si256(t, 1));
+        _mm_storel_epi64((__m128i *)(nos + i), _mm_packus_epi16(r, r));
+    }
+    compose_plane_8(nos + i, tos + i, scale + i, n - i);
+}
+#endif
+
+static compose_plane_8_fn
+get_compose_plane_8(void)
+{
+#ifdef COMPOSE_PLANE_SIMD
+    /* Racing threads will all store the same value. */
+    static compose_plane_8_fn fn = NULL;
+
+    if (fn == NULL) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            fn = compose_plane_8_AVX2;
+        else if (__builtin_cpu_supports("sse4.1"))
+            fn = compose_plane_8_SSE41;
+        else
+            fn = compose_plane_8;
+    }
+    return fn;
+#else
+    return compose_plane_8;
+#endif
+}
+
 static void
 compose_group_nonknockout_nonblend_isolated_allmask_common(byte *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
               int tos_shape_offset, int tos_alpha_g_offset, int tos_tag_offset, bool tos_has_tag,
@@ -3082,56 +3187,62 @@ compose_group_nonknockout_nonblend_isolated_allmask_common(byte *tos_ptr, bool t
               const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
 {
     int width = x1 - x0;
-    int x, y;
-    int i;
+    byte *gs_restrict tos_alpha_ptr = tos_ptr + n_chan * tos_planestride;
+    byte *gs_restrict nos_alpha_ptr = nos_ptr + n_chan * nos_planestride;
+    compose_plane_8_fn compose_plane = get_compose_plane_8();
+    int scale[COMPOSE_CHUNK];
+    int x, y, i, n;
 
     for (y = y1 - y0; y > 0; --y) {
         byte *gs_restrict mask_curr_ptr = mask_row_ptr;
-        for (x = 0; x < width; x++) {
-            byte mask = mask_tr_fn[*mask_curr_ptr++];
-            byte src_alpha = tos_ptr[n_chan * tos_planestride];
-            if (src_alpha != 0) {
-                byte a_b;
 
-                int tmp = alpha * mask + 0x80;
-                byte pix_alpha = (tmp + (tmp >> 8)) >> 8;
+        for (x = 0; x < width; x += n) {
+            bool changed = false;
 
-                if (pix_alpha != 255) {
-                    int tmp = src_alpha * pix_alpha + 0x80;
-                    src_alpha = (tmp + (tmp >> 8)) >> 8;
-                }
+            n = min(width - x, COMPOSE_CHUNK);
+            for (i = 0; i < n; i++) {
+                byte mask = mask_tr_fn[*mask_curr_ptr++];
+                byte src_alpha = tos_alpha_ptr[x + i];
 
-                a_b = nos_ptr[n_chan * nos_planestride];
-                if (a_b == 0) {
-                    /* Simple copy of colors plus alpha. */
-                    for (i = 0; i < n_chan; i++) {
-                        nos_ptr[i * nos_planestride] = tos_ptr[i * tos_planestride];
-                    }
-                    nos_ptr[i * nos_planestride] = src_alpha;
-                } else {
-                    /* Result alpha is Union of backdrop and source alpha */
-                    int tmp = (0xff - a_b) * (0xff - src_alpha) + 0x80;
-                    unsigned int a_r = 0xff - (((tmp >> 8) + tmp) >> 8);
+                scale[i] = 0;
+                if (src_alpha != 0) {
+                    byte a_b;
 
-                    /* Compute src_alpha / a_r in 16.16 format */
-                    int src_scale = ((src_alpha << 16) + (a_r >> 1)) / a_r;
+                    int tmp = alpha * mask + 0x80;
+                    byte pix_alpha = (tmp + (tmp >> 8)) >> 8;
 
-                    nos_ptr[n_chan * nos_planestride] = a_r;
+                    if (pix_alpha != 255) {
+                        int tmp = src_alpha * pix_alpha + 0x80;
+                        src_alpha = (tmp + (tmp >> 8)) >> 8;
+                    }
 
-                    /* Do simple compositing of source over backdrop */
-                    for (i = 0; i < n_chan; i++) {
-                        int c_s = tos_ptr[i * tos_planestride];
-                        int c_b = nos_ptr[i * nos_planestride];
-                        tmp = src_scale * (c_s - c_b) + 0x8000;
-                        nos_ptr[i * nos_planestride] = c_b + (tmp >> 16);
+                    a_b = nos_alpha_ptr[x + i];
+                    if (a_b == 0) {
+                        /* Simple copy of colors plus alpha. */
+                        scale[i] = 0x10000;
+                        nos_alpha_ptr[x + i] = src_alpha;
+                    } else {
+                        /* Result alpha is Union of backdrop and source alpha */
+                        int tmp = (0xff - a_b) * (0xff - src_alpha) + 0x80;
+                        unsigned int a_r = 0xff - (((tmp >> 8) + tmp) >> 8);
+
+                        /* Compute src_alpha / a_r in 16.16 format */
+                        scale[i] = ((src_alpha << 16) + (a_r >> 1)) / a_r;
+                        nos_alpha_ptr[x + i] = a_r;
                     }
+                    changed = true;
                 }
             }
-            ++tos_ptr;
-            ++nos_ptr;
+            /* Do simple compositing of source over backdrop */
+            if (changed)
+                for (i = 0; i < n_chan; i++)
+                    compose_plane(nos_ptr + i * nos_planestride + x,
+                                  tos_ptr + i * tos_planestride + x, scale, n);
         }
-        tos_ptr += tos_rowstride - width;
-        nos_ptr += nos_rowstride - width;
+        tos_ptr += tos_rowstride;
+        nos_ptr += nos_rowstride;
+        tos_alpha_ptr += tos_rowstride;
+        nos_alpha_ptr += nos_rowstride;
         mask_row_ptr += maskbuf->rowstride;
     }
 }
@@ -3236,11 +3347,54 @@ compose_group_nonknockout_nonblend_isolated_nomask_common(byte *tos_ptr, bool to
               bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
               const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
 {
-    template_compose_group(tos_ptr, /*tos_isolated*/1, tos_planestride, tos_rowstride, alpha, shape, BLEND_MODE_Normal, /*tos_has_shape*/0,
-        tos_shape_offset, tos_alpha_g_offset, tos_tag_offset, /*tos_has_tag*/0,
-        nos_ptr, /*nos_isolated*/0, nos_planestride, nos_rowstride, /*nos_alpha_g_ptr*/0, /* nos_knockout = */0,
-        /*nos_shape_offset*/0, /*nos_tag_offset*/0, mask_row_ptr, /*has_mask*/0, /*maskbuf*/NULL, mask_bg_alpha, mask_tr_fn,
-        backdrop_ptr, /*has_matte*/0, n_chan, /*additive*/1, /*num_spots*/0, /*overprint*/0, /*drawn_comps*/0, x0, y0, x1, y1, pblend_procs, pdev, 1);
+    int width = x1 - x0;
+    byte *gs_restrict tos_alpha_ptr = tos_ptr + n_chan * tos_planestride;
+    byte *gs_restrict nos_alpha_ptr = nos_ptr + n_chan * nos_planestride;
+    compose_plane_8_fn compose_plane = get_compose_plane_8();
+    int scale[COMPOSE_CHUNK];
+    int x, y, i, n;
+
+    /* As template_compose_group for an isolated group in Normal blend
+       mode, with no mask, shape, tags or spots. */
+    for (y = y1 - y0; y > 0; --y) {
+        for (x = 0; x < width; x += n) {
+            bool changed = false;
+
+            n = min(width - x, COMPOSE_CHUNK);
+            for (i = 0; i < n; i++) {
+                byte src_alpha = tos_alpha_ptr[x + i];
+                byte a_b;
+
+                scale[i] = 0;
+                if (alpha != 255) {
+                    int tmp = src_alpha * alpha + 0x80;
+                    src_alpha = (tmp + (tmp >> 8)) >> 8;
+                }
+                if (src_alpha == 0)
+                    continue;
+                a_b = nos_alpha_ptr[x + i];
+                if (a_b == 0) {
+                    scale[i] = 0x10000;
+                    nos_alpha_ptr[x + i] = src_alpha;
+                } else {
+                    int tmp = (0xff - a_b) * (0xff - src_alpha) + 0x80;
+                    unsigned int a_r = 0xff - (((tmp >> 8) + tmp) >> 8);
+
+                    scale[i] = ((src_alpha << 16) + (a_r >> 1)) / a_r;
+                    nos_alpha_ptr[x + i] = a_r;
+                }
+                changed = true;
+            }
+            if (changed)
+                for (i = 0; i < n_chan; i++)
+                    compose_plane(nos_ptr + i * nos_planestride + x,
+                                  tos_ptr + i * tos_planestride + x, scale, n);
+        }
+        tos_ptr += tos_rowstride;
+        nos_ptr += nos_rowstride;
+        tos_alpha_ptr += tos_rowstride;
+        nos_alpha_ptr += nos_rowstride;
+    }
 }
 
 static void
@@ -3373,6 +3527,8 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
 
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
+    pdf14_buf_touch(tos, x0, y0, x1, y1);
+    pdf14_buf_touch(nos, x0, y0, x1, y1);
     rect_merge(nos->dirty, tos->dirty);
     if (nos->has_tags)
         if_debug7m('v', memory,
@@ -4144,6 +4300,8 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
 
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
+    pdf14_buf_touch(tos, x0, y0, x1, y1);
+    pdf14_buf_touch(nos, x0, y0, x1, y1);
     rect_merge(nos->dirty, tos->dirty);
     if (nos->has_tags)
         if_debug7m('v', memory,
@@ -4287,6 +4445,40 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
 #endif
 }
 
+/* Compose an 8 bit group into a 16 bit one. pdf14_pop_transparency_group
+   only lets that happen when the group holds nothing but opaque or clear
+   pixels and goes down in Normal mode with nothing else applied, onto a
+   buffer without shape or alpha_g, so it just replaces the backdrop
+   wherever it is opaque. */
+static void
+compose_group_8_16(pdf14_buf *tos, pdf14_buf *nos, int x0, int x1,
+                   int y0, int y1, int n_chan)
+{
+    int width = x1 - x0;
+    const byte *tos_ptr = tos->data + x0 - tos->rect.p.x +
+        (y0 - tos->rect.p.y) * tos->rowstride;
+    uint16_t *nos_ptr = (uint16_t *)(nos->data + ((x0 - nos->rect.p.x)<<1) +
+        (y0 - nos->rect.p.y) * nos->rowstride);
+    int tos_planestride = tos->planestride;
+    int nos_planestride = nos->planestride>>1;
+    const byte *tos_alpha_ptr = tos_ptr + (n_chan - 1) * tos_planestride;
+    int x, y, k;
+
+    pdf14_buf_touch(nos, x0, y0, x1, y1);
+    rect_merge(nos->dirty, tos->dirty);
+    for (y = y0; y < y1; y++) {
+        for (x = 0; x < width; x++) {
+            if (tos_alpha_ptr[x] == 0)
+                continue;
+            for (k = 0; k < n_chan; k++)
+                nos_ptr[x + k * nos_planestride] = tos_ptr[x + k * tos_planestride] * 257;
+        }
+        tos_ptr += tos->rowstride;
+        tos_alpha_ptr += tos->rowstride;
+        nos_ptr += nos->rowstride>>1;
+    }
+}
+
 void
 pdf14_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
               int x0, int x1, int y0, int y1, int n_chan, bool additive,
@@ -4294,7 +4486,9 @@ pdf14_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
               bool has_matte, bool overprint, gx_color_index drawn_comps,
               gs_memory_t *memory, gx_device *dev)
 {
-    if (tos->deep)
+    if (!tos->deep && nos->deep)
+        compose_group_8_16(tos, nos, x0, x1, y0, y1, n_chan);
+    else if (tos->deep)
         do_compose_group16(tos, nos, maskbuf, x0, x1, y0, y1, n_chan,
                            additive, pblend_procs, has_matte, overprint,
                            drawn_comps, memory, dev);
@@ -4348,6 +4542,8 @@ do_compose_alphaless_group(pdf14_buf *tos, pdf14_buf *nos,
 
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
+    pdf14_buf_touch(tos, x0, y0, x1, y1);
+    pdf14_buf_touch(nos, x0, y0, x1, y1);
     rect_merge(nos->dirty, tos->dirty);
     if (nos->has_tags)
         if_debug7m('v', memory,
@@ -4479,6 +4675,8 @@ do_compose_alphaless_group16(pdf14_buf *tos, pdf14_buf *nos,
 
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
+    pdf14_buf_touch(tos, x0, y0, x1, y1);
+    pdf14_buf_touch(nos, x0, y0, x1, y1);
     rect_merge(nos->dirty, tos->dirty);
     if (nos->has_tags)
         if_debug7m('v', memory,
@@ -5076,6 +5274,13 @@ do_mark_fill_rectangle(gx_device * dev, int x, int y, int w, int h,
                 src[j] = 255 - ((pdc->colors.devn.values[j]) >> shift & mask);
             }
         }
+    } else if (pdev->ctx->deep) {
+        /* An 8 bit group on a 16 bit device, see pdf14_mark_fill_rectangle */
+        uint16_t src16[PDF14_MAX_PLANES];
+
+        pdev->pdf14_procs->unpack_color16(num_comp, color, pdev, src16);
+        for (j = 0; j < num_comp; j++)
+            src[j] = src16[j] >> 8;
     } else
         pdev->pdf14_procs->unpack_color(num_comp, color, pdev, src);
     src_alpha = src[num_comp] = (byte)floor (255 * pdev->alpha + 0.5);
@@ -5092,6 +5297,7 @@ do_mark_fill_rectangle(gx_device * dev, int x, int y, int w, int h,
     }
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    pdf14_buf_touch(buf, x, y, x + w, y + h);
     /* Update the dirty rectangle with the mark */
     if (x < buf->dirty.p.x) buf->dirty.p.x = x;
     if (y < buf->dirty.p.y) buf->dirty.p.y = y;
@@ -5692,6 +5898,7 @@ do_mark_fill_rectangle16(gx_device * dev, int x, int y, int w, int h,
     }
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    pdf14_buf_touch(buf, x, y, x + w, y + h);
     /* Update the dirty rectangle with the mark */
     if (x < buf->dirty.p.x) buf->dirty.p.x = x;
     if (y < buf->dirty.p.y) buf->dirty.p.y = y;
@@ -5764,6 +5971,35 @@ do_mark_fill_rectangle16(gx_device * dev, int x, int y, int w, int h,
     return 0;
 }
 
+/* An opaque (or invisible) mark in Normal blend mode just replaces what is
+   under it, so if its color is exact at 8 bits an 8 bit group on a 16 bit
+   device can take it and still end up just as it would at 16 bits. */
+static bool
+mark_fits_8bit(pdf14_device *pdev, pdf14_buf *buf, gx_color_index color,
+               const gx_device_color *pdc, bool devn)
+{
+    uint16_t src[PDF14_MAX_PLANES];
+    uint16_t alpha = (uint16_t)floor (65535 * pdev->alpha + 0.5);
+    int num_comp = buf->n_chan - 1;
+    int j;
+
+    if (pdev->blend_mode != BLEND_MODE_Normal || pdev->overprint ||
+        buf->has_shape || buf->has_alpha_g || buf->has_tags ||
+        (alpha != 0 && alpha != 65535))
+        return false;
+    if (devn) {
+        for (j = 0; j < num_comp; j++)
+            if (pdc->colors.devn.values[j] % 257 != 0)
+                return false;
+    } else {
+        pdev->pdf14_procs->unpack_color16(num_comp, color, pdev, src);
+        for (j = 0; j < num_comp; j++)
+            if (src[j] % 257 != 0)
+                return false;
+    }
+    return true;
+}
+
 int
 pdf14_mark_fill_rectangle(gx_device * dev, int x, int y, int w, int h,
                           gx_color_index color, const gx_device_color *pdc,
@@ -5772,6 +6008,13 @@ pdf14_mark_fill_rectangle(gx_device * dev, int x, int y, int w, int h,
     pdf14_device *pdev = (pdf14_device *)dev;
     pdf14_buf *buf = pdev->ctx->stack;
 
+    if (!buf->deep && pdev->ctx->deep &&
+        !mark_fits_8bit(pdev, buf, color, pdc, devn)) {
+        int code = pdf14_buf_promote_deep(buf);
+
+        if (code < 0)
+            return code;
+    }
     if (buf->deep)
         return do_mark_fill_rectangle16(dev, x, y, w, h, color, pdc, devn);
     else
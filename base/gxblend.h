@@ -350,6 +350,20 @@ int pdf14_preserve_backdrop_cm(pdf14_buf *buf, cmm_profile_t *group_profile,
                                gs_memory_t *memory, gs_gstate *pgs,
                                gx_device *dev, bool knockout_buff);
 
+/* Lazily cleared group buffers; see tile_clear in gdevp14.h. Anything
+   that writes a rectangle of a buffer must touch it first, anything that
+   reads one without knowing about the tiles must touch all of it. */
+#define PDF14_TILE_SIZE 64
+
+bool pdf14_buf_make_lazy(pdf14_buf *buf);
+void pdf14_buf_touch(pdf14_buf *buf, int x0, int y0, int x1, int y1);
+void pdf14_buf_touch_all(pdf14_buf *buf);
+
+/* On a 16 bit device, isolated groups start out at 8 bits and are taken to
+   16 bits by this when something that needs them is drawn into the group,
+   or when it is composed (see pdf14_push_transparency_group). */
+int pdf14_buf_promote_deep(pdf14_buf *buf);
+
 void pdf14_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
               int x0, int x1, int y0, int y1, int n_chan, bool additive,
               const pdf14_nonseparable_blending_procs_t * pblend_procs,
@@ -385,6 +385,168 @@ pdf14_preserve_backdrop(pdf14_buf *buf, pdf14_buf *tos, bool knockout_buff
 }
 
 
+/* Set a newly pushed buffer up to be cleared a tile at a time as it is
+   marked, rather than all at once. Returns false (and does nothing) if the
+   buffer is too small for this to be worthwhile, or the tile map cannot
+   be allocated; the caller must then clear the buffer itself. */
+bool
+pdf14_buf_make_lazy(pdf14_buf *buf)
+{
+    int tiles_x = (buf->rect.q.x - buf->rect.p.x + PDF14_TILE_SIZE - 1) / PDF14_TILE_SIZE;
+    int tiles_y = (buf->rect.q.y - buf->rect.p.y + PDF14_TILE_SIZE - 1) / PDF14_TILE_SIZE;
+
+    if (buf->data == NULL || tiles_x * tiles_y <= 4)
+        return false;
+    buf->tile_clear = gs_alloc_bytes(buf->memory, tiles_x * tiles_y,
+                                     "pdf14_buf_make_lazy");
+    if (buf->tile_clear == NULL)
+        return false;
+    memset(buf->tile_clear, 0, tiles_x * tiles_y);
+    buf->tiles_x = tiles_x;
+    buf->tiles_y = tiles_y;
+    buf->tiles_todo = tiles_x * tiles_y;
+    return true;
+}
+
+/* Clear any tiles of the buffer that intersect the given rectangle and
+   have not been cleared yet. The planes cleared are the ones that
+   pdf14_push_transparency_group would otherwise have cleared. */
+void
+pdf14_buf_touch(pdf14_buf *buf, int x0, int y0, int x1, int y1)
+{
+    int n_planes, tx0, tx1, ty0, ty1, tx, ty, i, y;
+    int deep = buf->deep;
+
+    if (buf->tile_clear == NULL)
+        return;
+    x0 = max(x0, buf->rect.p.x) - buf->rect.p.x;
+    y0 = max(y0, buf->rect.p.y) - buf->rect.p.y;
+    x1 = min(x1, buf->rect.q.x) - buf->rect.p.x;
+    y1 = min(y1, buf->rect.q.y) - buf->rect.p.y;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    n_planes = buf->n_chan + (buf->has_shape ? 1 : 0) +
+               (buf->has_alpha_g ? 1 : 0);
+    tx0 = x0 / PDF14_TILE_SIZE;
+    tx1 = (x1 - 1) / PDF14_TILE_SIZE;
+    ty0 = y0 / PDF14_TILE_SIZE;
+    ty1 = (y1 - 1) / PDF14_TILE_SIZE;
+    for (ty = ty0; ty <= ty1; ty++) {
+        byte *flags = buf->tile_clear + ty * buf->tiles_x;
+        int py0 = ty * PDF14_TILE_SIZE;
+        int py1 = min(py0 + PDF14_TILE_SIZE, buf->rect.q.y - buf->rect.p.y);
+
+        for (tx = tx0; tx <= tx1; tx++) {
+            int px0 = tx * PDF14_TILE_SIZE;
+            int w = min(px0 + PDF14_TILE_SIZE, buf->rect.q.x - buf->rect.p.x) - px0;
+
+            if (flags[tx])
+                continue;
+            for (i = 0; i < n_planes; i++) {
+                byte *row = buf->data + i * buf->planestride +
+                            py0 * buf->rowstride + (px0<<deep);
+
+                /* Memsetting by 0, so this copes with the deep case too */
+                for (y = py0; y < py1; y++, row += buf->rowstride)
+                    memset(row, 0, w<<deep);
+            }
+            flags[tx] = 1;
+            buf->tiles_todo--;
+        }
+    }
+    if (buf->tiles_todo == 0) {
+        gs_free_object(buf->memory, buf->tile_clear, "pdf14_buf_touch");
+        buf->tile_clear = NULL;
+    }
+}
+
+/* Clear all the tiles not cleared yet, leaving an ordinary buffer. */
+void
+pdf14_buf_touch_all(pdf14_buf *buf)
+{
+    if (buf->tile_clear != NULL)
+        pdf14_buf_touch(buf, buf->rect.p.x, buf->rect.p.y,
+                        buf->rect.q.x, buf->rect.q.y);
+}
+
+static void
+expand_planes_part(uint16_t *des, int des_rowstride, int des_planestride,
+                   const byte *src, int src_rowstride, int src_planestride,
+                   int n_planes, int width, int height)
+{
+    int i, x, y;
+
+    for (i = 0; i < n_planes; i++) {
+        uint16_t *d = des + i * des_planestride;
+        const byte *s = src + i * src_planestride;
+
+        for (y = 0; y < height; y++) {
+            for (x = 0; x < width; x++)
+                d[x] = s[x] * 257;
+            d += des_rowstride;
+            s += src_rowstride;
+        }
+    }
+}
+
+/* Take an 8 bit group buffer on a 16 bit device up to 16 bits. Every 8 bit
+   value v is exactly v * 257 at 16 bits, so nothing drawn so far changes.
+   Tiles of a lazily cleared buffer that have not been cleared yet are left
+   for pdf14_buf_touch to clear at the new depth. */
+int
+pdf14_buf_promote_deep(pdf14_buf *buf)
+{
+    int width = buf->rect.q.x - buf->rect.p.x;
+    int height = buf->rect.q.y - buf->rect.p.y;
+    int rowstride = buf->rowstride << 1;
+    int planestride = rowstride * height;
+    byte *data;
+    int tx, ty;
+
+    if (buf->deep)
+        return 0;
+    if (buf->data == NULL) {
+        buf->rowstride = rowstride;
+        buf->deep = true;
+        return 0;
+    }
+    if ((double)planestride * buf->n_planes > (double)max_uint)
+        return_error(gs_error_VMerror);
+    data = gs_alloc_bytes(buf->memory, planestride * buf->n_planes,
+                          "pdf14_buf_promote_deep");
+    if (data == NULL)
+        return_error(gs_error_VMerror);
+    if (buf->tile_clear == NULL)
+        expand_planes_part((uint16_t *)data, rowstride >> 1, planestride >> 1,
+                           buf->data, buf->rowstride, buf->planestride,
+                           buf->n_planes, width, height);
+    else {
+        for (ty = 0; ty < buf->tiles_y; ty++) {
+            int y0 = ty * PDF14_TILE_SIZE;
+            int h = min(y0 + PDF14_TILE_SIZE, height) - y0;
+
+            for (tx = 0; tx < buf->tiles_x; tx++) {
+                int x0 = tx * PDF14_TILE_SIZE;
+                int w = min(x0 + PDF14_TILE_SIZE, width) - x0;
+
+                if (!buf->tile_clear[ty * buf->tiles_x + tx])
+                    continue;
+                expand_planes_part((uint16_t *)(data + y0 * rowstride) + x0,
+                                   rowstride >> 1, planestride >> 1,
+                                   buf->data + y0 * buf->rowstride + x0,
+                                   buf->rowstride, buf->planestride,
+                                   buf->n_planes, w, h);
+            }
+        }
+    }
+    gs_free_object(buf->memory, buf->data, "pdf14_buf_promote_deep");
+    buf->data = data;
+    buf->rowstride = rowstride;
+    buf->planestride = planestride;
+    buf->deep = true;
+    return 0;
+}
+
 /*
  * Encode a list of colorant values into a gx_color_index_value.
  */
@@ -143,7 +143,7 @@ gx_lookup_fm_pair(gs_font * pfont, const gs_matrix *char_tm,
 /* Look up a glyph with the right depth in the cache. */
 /* Return the cached_char or 0. */
 cached_char *
-gx_lookup_cached_char(const gs_font * pfont, const cached_fm_pair * pair,
+gx_lookup_cached_char(const gs_font * pfont, cached_fm_pair * pair,
                       gs_glyph glyph, int wmode, int depth,
                       gs_fixed_point *subpix_origin)
 {
@@ -151,6 +151,8 @@ gx_lookup_cached_char(const gs_font * pfont, const cached_fm_pair * pair,
     uint chi = chars_head_index(glyph, pair);
     register cached_char *cc;
 
+    dir->ccache.lookups++;
+    pair->lookups++;
     while ((cc = dir->ccache.table[chi & dir->ccache.table_mask]) != 0) {
         if (cc->code == glyph && cc_pair(cc) == pair &&
             cc->subpix_origin.x == subpix_origin->x &&
@@ -160,6 +162,8 @@ gx_lookup_cached_char(const gs_font * pfont, const cached_fm_pair * pair,
             if_debug4m('K', pfont->memory,
                        "[K]found 0x%lx (depth=%d) for glyph=0x%lx, wmode=%d\n",
                        (ulong) cc, cc_depth(cc), (ulong) glyph, wmode);
+            dir->ccache.hits++;
+            pair->hits++;
             return cc;
         }
         chi++;
@@ -63,22 +63,27 @@ static int alloc_char(gs_font_dir *, ulong, cached_char **);
 static int alloc_char_in_chunk(gs_font_dir *, ulong, cached_char **);
 static void hash_remove_cached_char(gs_font_dir *, uint);
 static void shorten_cached_char(gs_font_dir *, cached_char *, uint);
+static void adapt_char_cache_size(gs_font_dir *);
 
 /* ====== Initialization ====== */
 
 /* Allocate and initialize the character cache elements of a font directory. */
 int
 gx_char_cache_alloc(gs_memory_t * struct_mem, gs_memory_t * bits_mem,
-            gs_font_dir * pdir, uint bmax, uint mmax, uint cmax, uint upper)
+            gs_font_dir * pdir, uint bmax, uint bmax_target, uint mmax,
+            uint cmax, uint upper)
 {				/* Since we use open hashing, we must increase cmax somewhat. */
     uint chsize = (cmax + (cmax >> 1)) | 31;
     cached_fm_pair *mdata;
     cached_char **chars;
 
+    if (bmax_target < bmax)
+        bmax_target = bmax;
     /* the table size must be adjusted upward such that we overflow
        cache character memory before filling the table.  The searching
-       code uses an empty table entry as a sentinel. */
-    chsize = max(chsize, ROUND_UP(bmax, sizeof_cached_char) / sizeof_cached_char + 1);
+       code uses an empty table entry as a sentinel.  bmax may grow
+       up to bmax_target, so size the table for that. */
+    chsize = max(chsize, ROUND_UP(bmax_target, sizeof_cached_char) / sizeof_cached_char + 1);
     
     /* Round up chsize to a power of 2. */
     while (chsize & (chsize + 1))
@@ -102,6 +107,7 @@ gx_char_cache_alloc(gs_memory_t * struct_mem, gs_memory_t * bits_mem,
     pdir->ccache.struct_memory = struct_mem;
     pdir->ccache.bits_memory = bits_mem;
     pdir->ccache.bmax = bmax;
+    pdir->ccache.bmax_target = bmax_target;
     pdir->ccache.cmax = cmax;
     pdir->ccache.lower = upper / 10;
     pdir->ccache.upper = upper;
@@ -345,6 +351,7 @@ gx_add_fm_pair(register gs_font_dir * dir, gs_font * font, const gs_uid * puid,
     pair->mxx = mxx, pair->mxy = mxy;
     pair->myx = myx, pair->myy = myy;
     pair->num_chars = 0;
+    pair->lookups = pair->hits = 0;
     pair->xfont_tried = false;
     pair->xfont = 0;
     pair->ttf = 0;
@@ -707,6 +714,7 @@ cached_char * cc, cached_fm_pair * pair, const gs_log2_scale_point * pscale)
         cc->linked = true;
         cc_set_pair(cc, pair);
         pair->num_chars++;
+        dir->ccache.additions++;
     }
     return 0;
 }
@@ -928,6 +936,8 @@ alloc_char(gs_font_dir * dir, ulong icdsize, cached_char **pcc)
     if (code < 0)
         return code;
     if (cc == 0) {
+        if (dir->ccache.bspace >= dir->ccache.bmax)
+            adapt_char_cache_size(dir);
         if (dir->ccache.bspace < dir->ccache.bmax) {	/* Allocate another chunk. */
             gs_memory_t *mem = dir->ccache.bits_memory;
             char_cache_chunk *cck_prev = dir->ccache.chunks;
@@ -987,6 +997,36 @@ alloc_char(gs_font_dir * dir, ulong icdsize, cached_char **pcc)
     return 0;
 }
 
+/*
+ * The cache is full.  If enough lookups have been made since the last
+ * decision and more than a quarter of them missed, raise bmax by a
+ * twentieth of bmax_target (a chunk of the default cache) instead of
+ * starting to discard characters.
+ */
+#define adapt_min_lookups 256
+static void
+adapt_char_cache_size(gs_font_dir * dir)
+{
+    char_cache *pcc = &dir->ccache;
+    ulong lookups = pcc->lookups - pcc->adapt_lookups;
+    ulong misses = lookups - (pcc->hits - pcc->adapt_hits);
+    uint step;
+
+    if (pcc->bmax >= pcc->bmax_target || lookups < adapt_min_lookups)
+        return;
+    pcc->adapt_lookups = pcc->lookups;
+    pcc->adapt_hits = pcc->hits;
+    if (misses * 4 <= lookups)
+        return;
+    step = pcc->bmax_target / 20 + 1;
+    if (step > pcc->bmax_target - pcc->bmax)
+        step = pcc->bmax_target - pcc->bmax;
+    pcc->bmax += step;
+    pcc->grows++;
+    if_debug3m('k', dir->memory, "[k]growing cache: bmax=%u (%lu misses in %lu lookups)\n",
+               pcc->bmax, misses, lookups);
+}
+
 /* Allocate a character in the current chunk. */
 static int
 alloc_char_in_chunk(gs_font_dir * dir, ulong icdsize, cached_char **pcc)
@@ -1016,6 +1056,7 @@ alloc_char_in_chunk(gs_font_dir * dir, ulong icdsize, cached_char **pcc)
                         return_error(gs_error_unregistered); /* Must not happen. */
                 }
                 hash_remove_cached_char(dir, chi);
+                dir->ccache.evictions++;
             }
 
             gx_free_cached_char(dir, cc);
@@ -442,8 +442,25 @@ compute_glyph_raster_params(gs_show_enum *penum, bool in_setcachedevice, int *al
     *depth = (log2_scale->x + log2_scale->y == 0 ?
         1 : min(log2_scale->x + log2_scale->y, *alpha_bits));
     if (gs_currentaligntopixels(penum->current_font->dir) == 0) {
-        int scx = -1L << (_fixed_shift - log2_scale->x);
-        int rdx =  1L << (_fixed_shift - 1 - log2_scale->x);
+        int log2_phases = log2_scale->x;
+        int scx, rdx;
+
+        /*
+         * With anti-aliasing, SubpixelPhases may ask for finer horizontal
+         * phases than the oversampling gives. Each phase is a separate
+         * cache entry, rasterized on first use through the cache device
+         * translation (see set_cache_device). FAPI renders bitmaps at a
+         * fixed origin, so its glyphs keep the default quantization.
+         */
+        if (*alpha_bits > 1 && penum->current_font->FontType != ft_composite &&
+            ((gs_font_base *)penum->current_font)->FAPI == NULL) {
+            uint phases = gs_currentsubpixelphases(penum->current_font->dir);
+
+            while (phases > (1u << log2_phases))
+                log2_phases++;
+        }
+        scx = -1L << (_fixed_shift - log2_phases);
+        rdx =  1L << (_fixed_shift - 1 - log2_phases);
 
 #       if 1 /* Ever align Y to pixels to provide an uniform glyph height. */
             subpix_origin->y = 0;
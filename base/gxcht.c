@@ -23,6 +23,7 @@
 #include "gxfixed.h"
 #include "gxmatrix.h"
 #include "gxdevice.h"
+#include "gxdevmem.h"		/* for planar memory devices */
 #include "gxcmap.h"
 #include "gxdcolor.h"
 #include "gxgstate.h"
@@ -555,6 +556,29 @@ static SET_HT_COLORS_PROC(set_ht_colors_gt_4);
 static SET_COLOR_HT_PROC(set_color_ht_le_4);
 static SET_COLOR_HT_PROC(set_color_ht_gt_4);
 
+/*
+ * For planar memory devices with 1 bit per plane, we render each plane
+ * directly.  Every plane is either constant (set = 0xff) or the OR of
+ * the tiles of the halftoned components in pos, and of the inverted
+ * tiles of the components in inv.
+ */
+typedef struct ht_planar_plane_s {
+    byte set;
+    gx_color_index pos, inv;
+} ht_planar_plane_t;
+
+static bool set_ht_planar_planes(ht_planar_plane_t pplanes[MAX_DCC],
+                                 gx_color_index *pht_mask,
+                                 const gx_device *dev, int nplanes,
+                                 int special, gx_color_index plane_mask,
+                                 const gx_color_index colors[MAX_DCC_16],
+                                 const gx_const_strip_bitmap * sbits[MAX_DCC]);
+static void set_color_ht_planar(byte *dest_data, uint dest_raster,
+                                int px, int py, int w, int h, int nplanes,
+                                const ht_planar_plane_t pplanes[MAX_DCC],
+                                gx_color_index ht_mask,
+                                const gx_const_strip_bitmap * sbits[MAX_DCC]);
+
 /* Prepare to use a colored halftone, by loading the default cache. */
 static int
 gx_dc_ht_colored_load(gx_device_color * pdevc, const gs_gstate * pgs,
@@ -669,6 +693,53 @@ gx_dc_ht_colored_fill_rectangle(const gx_device_color * pdevc,
     if ((!no_rop) && (source == NULL))
         set_rop_no_source(source, no_source, dev);
 
+    if (no_rop && dev->is_planar && gs_device_is_memory(dev) &&
+        (special > 0 || set_ht_colors == set_ht_colors_gt_4) &&
+        nplanes * align_bitmap_mod <= tile_bytes) {
+        ht_planar_plane_t planes[MAX_DCC];
+        gx_color_index ht_mask;
+
+        if (set_ht_planar_planes(planes, &ht_mask, dev, nplanes, special,
+                                 pdevc->colors.colored.plane_mask,
+                                 colors, sbits)) {
+            /*
+             * Render straight into planes: this avoids both building
+             * chunky pixels and having the device split them up again.
+             */
+            uint plane_bytes =
+                (tile_bytes / nplanes) & ~(align_bitmap_mod - 1);
+            int cx, cy, cw, ch;
+
+            fit_fill(dev, x, y, w, h);
+            raster = bitmap_raster(w + 7);
+            if (raster > plane_bytes) {
+                dw = plane_bytes * 8 - 7;
+                raster = plane_bytes;
+                dh = 1;
+            } else {
+                dw = w;
+                dh = plane_bytes / raster;
+            }
+            for (cy = y; cy < y + h; cy += ch) {
+                ch = min(dh, y + h - cy);
+                for (cx = x; cx < x + w; cx += cw) {
+                    cw = min(dw, x + w - cx);
+                    set_color_ht_planar((byte *)tbits, raster,
+                                        cx + pdevc->phase.x,
+                                        cy + pdevc->phase.y,
+                                        cw, ch, nplanes, planes, ht_mask,
+                                        sbits);
+                    code = (*dev_proc(dev, copy_planes))
+                        (dev, (byte *)tbits, -cw & 7, raster,
+                         gx_no_bitmap_id, cx, cy, cw, ch, ch);
+                    if (code < 0)
+                        return code;
+                }
+            }
+            return code;
+        }
+    }
+
     /*
      * If the LCM of the plane cell sizes is smaller than the rectangle
      * being filled, compute a single tile and let tile_rectangle do the
@@ -1171,6 +1242,29 @@ wrap_shifted_cursor(tile_cursor_t *ptc, const gx_const_strip_bitmap *psbit)
     c.bit_shift = c.xshift;\
   END
 
+/*
+ * Get the next byte's worth of bits from a tile cursor into 'bits',
+ * moving right to left: the low-order bit is the rightmost pixel.
+ * Note that there may be excess bits set beyond the 8th.
+ */
+#define NEXT_BITS(c)\
+  BEGIN\
+    if (c.data > c.row) {\
+      bits = ((c.data[-1] << 8) | *c.data) >> c.bit_shift;\
+      c.data--;\
+    } else {\
+      bits = *c.data >> c.bit_shift;\
+      c.data += c.xbytes;\
+      if ((c.bit_shift -= c.xbits) < 0) {\
+        bits |= *c.data << -c.bit_shift;\
+        c.bit_shift += 8;\
+      } else {\
+        bits |= ((c.data[-1] << 8) | *c.data) >> c.bit_shift;\
+        c.data--;\
+      }\
+    }\
+  END
+
 /* Define a table for expanding 8x1 bits to 8x4. */
 static const bits32 expand_8x1_to_8x4[256] = {
 #define X16(c)\
@@ -1239,25 +1333,6 @@ set_color_ht_le_4(byte *dest_data, uint dest_raster, int px, int py,
             int nx, i;
             register uint bits;
 
-/* Get the next byte's worth of bits.  Note that there may be */
-/* excess bits set beyond the 8th. */
-#define NEXT_BITS(c)\
-  BEGIN\
-    if (c.data > c.row) {\
-      bits = ((c.data[-1] << 8) | *c.data) >> c.bit_shift;\
-      c.data--;\
-    } else {\
-      bits = *c.data >> c.bit_shift;\
-      c.data += c.xbytes;\
-      if ((c.bit_shift -= c.xbits) < 0) {\
-        bits |= *c.data << -c.bit_shift;\
-        c.bit_shift += 8;\
-      } else {\
-        bits |= ((c.data[-1] << 8) | *c.data) >> c.bit_shift;\
-        c.data--;\
-      }\
-    }\
-  END
             if (plane_mask & 1) {
                 NEXT_BITS(cursor[0]);
                 indices = expand_8x1_to_8x4[bits & 0xff];
@@ -1275,7 +1350,6 @@ set_color_ht_le_4(byte *dest_data, uint dest_raster, int px, int py,
                 NEXT_BITS(cursor[3]);
                 indices |= expand_8x1_to_8x4[bits & 0xff] << 3;
             }
-#undef NEXT_BITS
             nx = min(x, 8);	/* 1 <= nx <= 8 */
             x -= nx;
             switch (dbytes) {
@@ -1426,53 +1500,57 @@ set_color_ht_gt_4(byte *dest_data, uint dest_raster, int px, int py,
                 base_color |= colors[2 * i];
     }
 
-    /* Now compute the actual tile. */
+    /*
+     * Now compute the actual tile, 8 pixels at a time.  For each
+     * halftoned plane we fetch a byte of the tile, whose low-order bit is
+     * the rightmost pixel, and select between the plane's two colors for
+     * all 8 pixels without branching: c0 ^ ((c0 ^ c1) & -bit).
+     */
     for (y = h; ; dest_row -= dest_raster) {
         byte *dest = dest_row;
         int i;
 
         --y;
         for (x = w; x > 0;) {
-            gx_color_index tcolor = base_color;
+            gx_color_index tcolor[8];
+            int nx = min(x, 8);	/* 1 <= nx <= 8 */
+            int j;
 
+            for (j = 0; j < 8; ++j)
+                tcolor[j] = base_color;
             for (i = pmin; i <= pmax; ++i)
                 if ((plane_mask >> i) & 1) {
-                    /* Get the next bit from an individual mask. */
-                    tile_cursor_t *ptc = &cursor[i];
-                    byte tile_bit;
-
-b:		    if (ptc->bit_shift < 8)
-                        tile_bit = *ptc->data >> ptc->bit_shift++;
-                    else if (ptc->data > ptc->row) {
-                        tile_bit = *--(ptc->data);
-                        ptc->bit_shift = 1;
-                    } else {
-                        /* Wrap around. */
-                        ptc->data += ptc->xbytes;
-                        ptc->bit_shift = 8 - ptc->xbits;
-                        goto b;
-                    }
-                    tcolor |= colors[2 * i + (tile_bit & 1)];
+                    gx_color_index c0 = colors[2 * i];
+                    gx_color_index cdiff = c0 ^ colors[2 * i + 1];
+                    register uint bits;
+
+                    NEXT_BITS(cursor[i]);
+                    for (j = 0; j < 8; ++j)
+                        tcolor[j] |= c0 ^ (cdiff &
+                                    ((gx_color_index)0 -
+                                     (gx_color_index)((bits >> j) & 1)));
+                }
+            for (j = 0; j < nx; ++j) {
+                --x;
+                switch (dbytes) {
+                    case 0:	/* 4 -- might be 2, but we don't support this */
+                        if (x & 1) { /* odd nibble */
+                            *--dest = (byte)tcolor[j];
+                        } else {	/* even nibble */
+                            *dest = (*dest & 0xf) + ((byte)tcolor[j] << 4);
+                        }
+                        break;
+                    case 4:	/* 32 */
+                        dest[-4] = (byte)(tcolor[j] >> 24);
+                    case 3:	/* 24 */
+                        dest[-3] = (byte)(tcolor[j] >> 16);
+                    case 2:	/* 16 */
+                        dest[-2] = (byte)(tcolor[j] >> 8);
+                    case 1:	/* 8 */
+                        dest[-1] = (byte)tcolor[j];
+                        dest -= dbytes;
+                        break;
                 }
-            --x;
-            switch (dbytes) {
-                case 0:	/* 4 -- might be 2, but we don't support this */
-                    if (x & 1) { /* odd nibble */
-                        *--dest = (byte)tcolor;
-                    } else {	/* even nibble */
-                        *dest = (*dest & 0xf) + ((byte)tcolor << 4);
-                    }
-                    break;
-                case 4:	/* 32 */
-                    dest[-4] = (byte)(tcolor >> 24);
-                case 3:	/* 24 */
-                    dest[-3] = (byte)(tcolor >> 16);
-                case 2:	/* 16 */
-                    dest[-2] = (byte)(tcolor >> 8);
-                case 1:	/* 8 */
-                    dest[-1] = (byte)tcolor;
-                    dest -= dbytes;
-                    break;
             }
         }
         if (y == 0)
@@ -1482,3 +1560,141 @@ b:		    if (ptc->bit_shift < 8)
                 STEP_ROW(cursor[i], i);
     }
 }
+
+/*
+ * Work out how to render each plane of a planar memory device with 1 bit
+ * per plane from the colors and tiles set up by set_cmyk_1bit_colors or
+ * set_ht_colors_gt_4.  Like set_color_ht_gt_4, we assume that the color
+ * of a pixel is the bitwise or of the colors of its components.  Return
+ * false if the device doesn't have the right layout.
+ */
+static bool
+set_ht_planar_planes(ht_planar_plane_t pplanes[MAX_DCC],
+                     gx_color_index *pht_mask, const gx_device *dev,
+                     int nplanes, int special, gx_color_index plane_mask,
+                     const gx_color_index colors[MAX_DCC_16],
+                     const gx_const_strip_bitmap * sbits[MAX_DCC])
+{
+    const gx_device_memory *mdev = (const gx_device_memory *)dev;
+    gx_color_index c0[MAX_DCC], c1[MAX_DCC];
+    gx_color_index ht_mask = 0;
+    int i, p;
+
+    if (mdev->color_info.num_components != nplanes)
+        return false;
+    for (p = 0; p < nplanes; ++p)
+        if (mdev->planes[p].depth != 1 ||
+            mdev->planes[p].shift >= 8 * sizeof(gx_color_index))
+            return false;
+    if (special > 0) {
+        /*
+         * Tile i (in reversed plane order) gives bit i of the pixel:
+         * out = (in & colors[1]) | (~in & colors[0]).
+         */
+        for (i = 0; i < 4; ++i) {
+            gx_color_index bit = (gx_color_index)1 << i;
+
+            c0[i] = colors[0] & bit;
+            c1[i] = colors[1] & bit;
+            if (sbits[i] != &ht_no_bitmap)
+                ht_mask |= bit;
+        }
+    } else {
+        for (i = 0; i < nplanes; ++i) {
+            c0[i] = colors[2 * i];
+            if ((plane_mask >> i) & 1) {
+                c1[i] = colors[2 * i + 1];
+                ht_mask |= (gx_color_index)1 << i;
+            } else
+                c1[i] = c0[i];
+        }
+    }
+    for (p = 0; p < nplanes; ++p) {
+        ht_planar_plane_t *pp = &pplanes[p];
+        int shift = mdev->planes[p].shift;
+
+        pp->set = 0;
+        pp->pos = pp->inv = 0;
+        for (i = 0; i < nplanes; ++i) {
+            int b0 = (int)(c0[i] >> shift) & 1;
+            int b1 = (int)(c1[i] >> shift) & 1;
+
+            if (b0 && b1)
+                pp->set = 0xff;
+            else if (b1)
+                pp->pos |= (gx_color_index)1 << i;
+            else if (b0)
+                pp->inv |= (gx_color_index)1 << i;
+        }
+        if (pp->set)
+            pp->pos = pp->inv = 0;
+    }
+    *pht_mask = ht_mask;
+    return true;
+}
+
+/*
+ * Render the halftone for a planar memory device with 1 bit per plane.
+ * Plane p is stored at dest_data + p * dest_raster * h.  We place the
+ * rectangle so that its right edge falls on a byte boundary (the data
+ * start at bit -w & 7 of each row), so every byte fetched from the tiles
+ * lands on exactly one output byte.
+ */
+static void
+set_color_ht_planar(byte *dest_data, uint dest_raster, int px, int py,
+                    int w, int h, int nplanes,
+                    const ht_planar_plane_t pplanes[MAX_DCC],
+                    gx_color_index ht_mask,
+                    const gx_const_strip_bitmap * sbits[MAX_DCC])
+{
+    tile_cursor_t cursor[MAX_DCC];
+    byte tbytes[MAX_DCC];
+    uint plane_size = dest_raster * h;
+    int nbytes = (w + 7) >> 3;
+    int x, y, i, p;
+
+    if_debug5('h', "[h]color_ht_planar: x=%d y=%d w=%d h=%d planes=%d\n",
+              px, py, w, h, nplanes);
+
+    /* Do one-time cursor initialization. */
+    {
+        int endx = w + px;
+        int lasty = h - 1 + py;
+
+        for (i = 0; i < nplanes; ++i)
+            if ((ht_mask >> i) & 1)
+                init_tile_cursor(i, &cursor[i], sbits[i], endx, lasty);
+    }
+
+    for (y = h; ; ) {
+        byte *dest_row = dest_data + --y * dest_raster;
+
+        for (x = nbytes; --x >= 0;) {
+            for (i = 0; i < nplanes; ++i)
+                if ((ht_mask >> i) & 1) {
+                    register uint bits;
+
+                    NEXT_BITS(cursor[i]);
+                    tbytes[i] = (byte)bits;
+                }
+            for (p = 0; p < nplanes; ++p) {
+                const ht_planar_plane_t *pp = &pplanes[p];
+                byte v = pp->set;
+                gx_color_index m;
+
+                for (m = pp->pos, i = 0; m != 0; m >>= 1, ++i)
+                    if (m & 1)
+                        v |= tbytes[i];
+                for (m = pp->inv, i = 0; m != 0; m >>= 1, ++i)
+                    if (m & 1)
+                        v |= ~tbytes[i];
+                dest_row[p * plane_size + x] = v;
+            }
+        }
+        if (y == 0)
+            break;
+        for (i = 0; i < nplanes; ++i)
+            if ((ht_mask >> i) & 1)
+                STEP_ROW(cursor[i], i);
+    }
+}
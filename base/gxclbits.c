@@ -34,8 +34,14 @@
  *      N to write in all bands when the character has been seen in N+1
  *         bands on a page;
  *      max_ushort to never write in all bands.
+ * A bitmap written in all bands is stored in the band list once, rather
+ * than once per band, but every band has to read it.  So we also wait
+ * until the character has been seen in at least 1/CHAR_ALL_BANDS_SHARE
+ * of the bands, so that a glyph used near the top of a page with many
+ * bands doesn't get read by all the others.
  */
-#define CHAR_ALL_BANDS_COUNT max_ushort
+#define CHAR_ALL_BANDS_COUNT 2
+#define CHAR_ALL_BANDS_SHARE 4
 
 /* ------ Writing ------ */
 
@@ -790,7 +796,8 @@ clist_change_bits(gx_device_clist_writer * cldev, gx_clist_state * pcls,
 
             if (tiles->num_planes != 1)
                     pdepth /= loc.tile->num_planes;
-            if (loc.tile->num_bands == CHAR_ALL_BANDS_COUNT)
+            if (loc.tile->num_bands >= CHAR_ALL_BANDS_COUNT &&
+                loc.tile->num_bands * CHAR_ALL_BANDS_SHARE >= cldev->nbands)
                 bit_pcls = NULL;
             /* put the bits, but don't restrict to a single buffer */
             code = cmd_put_bits(cldev, bit_pcls, ts_bits(cldev, loc.tile),
@@ -811,9 +818,17 @@ clist_change_bits(gx_device_clist_writer * cldev, gx_clist_state * pcls,
             dp = cmd_put_w(loc.index, dp);
             cmd_put_w(offset, dp);
             if (bit_pcls == NULL) {
+                int band;
+
                 memset(ts_mask(loc.tile), 0xff,
                        cldev->tile_band_mask_size);
                 loc.tile->num_bands = cldev->nbands;
+                /* Reading the bits makes this the current tile in */
+                /* every band, so keep the writer's view in step. */
+                for (band = 0; band < cldev->nbands; ++band) {
+                    cldev->states[band].tile_index = loc.index;
+                    cldev->states[band].tile_id = loc.tile->id;
+                }
             } else {
                 *bptr |= bmask;
                 loc.tile->num_bands++;
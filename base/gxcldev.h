@@ -110,6 +110,9 @@ typedef enum {
     cmd_op_copy_mono_planes = 0x90,	/* +compress, plane_height, x#, y#, (w+data_x)#, */
                                         /* h#, <bits> | */
 #define cmd_copy_use_tile 8             /* +8 (use tile), x#, y# | */
+#define cmd_copy_rel_xy 4               /* +8+4 (use tile), dx, dy */
+                                        /* (dx, dy relative to the */
+                                        /* last rect, no plane_height) */
     cmd_op_copy_color_alpha = 0xa0,	/* (same as copy_mono, except: */
                                 /* if color, ignore ht_color; */
                                 /* if alpha & !use_tile, depth is */
@@ -297,7 +300,8 @@ struct gx_clist_state_s {
         { 0, 0 }, /* cmd_list */\
         { 0, /* or */\
           0, /* slow rop */\
-          { { max_int, max_int }, /* p */ { min_int, min_int } /* q */ } /* trans_bbox */\
+          { { max_int, max_int }, /* p */ { min_int, min_int } /* q */ }, /* trans_bbox */\
+          0 /* trans_pattern */\
         } /* color_usage */
 
 /* Define the size of the command buffer used for reading. */
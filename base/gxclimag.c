@@ -249,13 +249,24 @@ clist_fill_mask(gx_device * dev,
             gx_cmd_rect rect;
             int rsize;
             byte op = copy_op + cmd_copy_use_tile;
+            int dx = orig_x - re.pcls->rect.x;
+            int dy = y0 - re.pcls->rect.y;
+            bool rel_xy = (dx >= cmd_min_short && dx <= cmd_max_short &&
+                           dy >= cmd_min_short && dy <= cmd_max_short);
 
             /* Output a command to copy the entire character. */
             /* It will be truncated properly per band. */
+            /* Consecutive characters of a text run are usually close */
+            /* to each other, so write their positions as deltas. */
             rect.x = orig_x, rect.y = y0;
             rect.width = orig_width, rect.height = re.yend - y0;
-            rsize = 1 + cmd_sizexy(rect);
-            if (depth == 1) rsize = rsize + cmd_sizew(0);  /* need planar_height 0 setting */
+            if (rel_xy) {
+                op += cmd_copy_rel_xy;
+                rsize = 3;
+            } else {
+                rsize = 1 + cmd_sizexy(rect);
+                if (depth == 1) rsize = rsize + cmd_sizew(0);  /* need planar_height 0 setting */
+            }
             code = (orig_data_x ?
                     cmd_put_set_data_x(cdev, re.pcls, orig_data_x) : 0);
             if (code >= 0) {
@@ -272,10 +283,15 @@ clist_fill_mask(gx_device * dev,
                  */
                 if (code >= 0) {
                     dp++;
-                    if (depth == 1) {
-                        cmd_putw(0, &dp);
+                    if (rel_xy) {
+                        dp[0] = (byte)(dx - cmd_min_short);
+                        dp[1] = (byte)(dy - cmd_min_short);
+                    } else {
+                        if (depth == 1) {
+                            cmd_putw(0, &dp);
+                        }
+                        cmd_putxy(rect, &dp);
                     }
-                    cmd_putxy(rect, &dp);
                 }
             }
             if (code < 0)
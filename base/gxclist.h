@@ -387,6 +387,8 @@ typedef struct gx_device_clist_reader_s {
                                         /* means all planes */
     const gx_placed_page *pages;
     gx_color_usage_t *color_usage_array; /* per band color_usage */
+    gs_int_rect trans_rect;		/* area of the band buffer that needs */
+                                        /* the pdf14 compositor, empty means all */
     int num_pages;
     void *offset_map; /* Just against collecting the map as garbage. */
     int num_render_threads;		/* number of threads being used */
@@ -265,19 +265,20 @@ cmd_put_drawing_color(gx_device_clist_writer * cldev, gx_clist_state * pcls,
         if (pattern_id &&
             (gx_pattern1_get_transptr(pdcolor) != NULL ||
              gx_pattern1_clist_has_trans(pdcolor))) {
+            gs_int_rect trans_bbox;
+
             /* update either this band or all bands with the trans_bbox */
+            trans_bbox.p.x = 0;
+            trans_bbox.q.x = cldev->width - 1;  /* no other information available */
             if (all_bands) {
-                pcls->color_usage.trans_bbox.p.x = 0;
-                pcls->color_usage.trans_bbox.q.x = cldev->width;  /* no other information available */
-                pcls->color_usage.trans_bbox.p.y = 0;
-                pcls->color_usage.trans_bbox.q.y = cldev->height;
-                clist_update_trans_bbox(cldev, &(pcls->color_usage.trans_bbox));
+                trans_bbox.p.y = 0;
+                trans_bbox.q.y = cldev->height - 1;
             } else {
-                pcls->color_usage.trans_bbox.p.x = 0;
-                pcls->color_usage.trans_bbox.q.x = cldev->width;  /* no other information available */
-                pcls->color_usage.trans_bbox.p.y = pre->y;
-                pcls->color_usage.trans_bbox.q.y = pre->yend;
+                trans_bbox.p.y = pre->y;
+                trans_bbox.q.y = min(pre->band_end, pre->yend) - 1;
             }
+            clist_update_trans_bbox(cldev, &trans_bbox);
+            pcls->color_usage.trans_pattern = true;
         }
     }
     if (is_pattern && all_bands) {
@@ -292,6 +293,7 @@ cmd_put_drawing_color(gx_device_clist_writer * cldev, gx_clist_state * pcls,
             pcls1->tile_phase.x = pcls->tile_phase.x;
             pcls1->tile_phase.y = pcls->tile_phase.y;
             pcls1->color_usage.or = pcls->color_usage.or;
+            pcls1->color_usage.trans_pattern |= pcls->color_usage.trans_pattern;
         }
     }
     return code;
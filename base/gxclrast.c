@@ -955,7 +955,10 @@ in:                             /* Initialize for a new page. */
                 state.rect.width += (op & 7) + cmd_min_dw_tiny;
                 break;
             case cmd_op_copy_mono_planes >> 4:
-                cmd_getw(plane_height, cbp);
+                if (op & cmd_copy_rel_xy)
+                    plane_height = 0;
+                else
+                    cmd_getw(plane_height, cbp);
                 if (plane_height == 0) {
                     /* We are doing a copy mono */
                     depth = 1;
@@ -971,8 +974,15 @@ in:                             /* Initialize for a new page. */
                 } else
                     depth = tdev->color_info.depth;
                 plane_height = 0;
-              copy:cmd_getw(state.rect.x, cbp);
-                cmd_getw(state.rect.y, cbp);
+              copy:if (op & cmd_copy_rel_xy) {
+                    /* A glyph from the cache placed near the previous one. */
+                    state.rect.x += cbp[0] + cmd_min_short;
+                    state.rect.y += cbp[1] + cmd_min_short;
+                    cbp += 2;
+                } else {
+                    cmd_getw(state.rect.x, cbp);
+                    cmd_getw(state.rect.y, cbp);
+                }
                 if (op & cmd_copy_use_tile) {   /* Use the current "tile". */
 #ifdef DEBUG
                     if (state_slot->index != state.tile_index) {
@@ -1605,6 +1615,15 @@ idata:                  data_size = 0;
                                             pcomp = NULL;
                                             continue;
                                         }
+                                        if (gs_is_pdf14trans_compositor(pcomp) &&
+                                            playback_action == playback_action_render) {
+                                            gs_pdf14trans_t *pdf14pct = (gs_pdf14trans_t *)pcomp;
+
+                                            /* Let the compositor know if it is only needed for part of the band */
+                                            if (pdf14pct->params.pdf14_op == PDF14_PUSH_DEVICE &&
+                                                !pdf14pct->params.is_pattern)
+                                                pdf14pct->params.page_rect = cdev->trans_rect;
+                                        }
                                         pcomp_opening = pcomp_last;
                                         closing_state = pcomp->type->procs.is_closing(pcomp, &pcomp_opening, tdev);
                                         switch(closing_state)
@@ -564,6 +564,8 @@ clist_render_init(gx_device_clist *dev)
     crdev->offset_map = NULL;
     crdev->icc_table = NULL;
     crdev->color_usage_array = NULL;
+    crdev->trans_rect.p.x = crdev->trans_rect.p.y = 0;
+    crdev->trans_rect.q.x = crdev->trans_rect.q.y = 0;
     crdev->render_threads = NULL;
 
     return 0;
@@ -763,6 +765,33 @@ clist_rasterize_lines(gx_device *dev, int y, int line_count,
     return line_count;
 }
 
+/* Copy out a rectangle of a rendered band so it can be put back later. */
+static int
+clist_save_rect(gx_device *bdev, const gs_int_rect *rect, byte **pdata,
+                uint *praster, gs_memory_t *mem)
+{
+    gs_get_bits_params_t params;
+    gs_int_rect r = *rect;
+    uint raster = bitmap_raster((r.q.x - r.p.x) * bdev->color_info.depth);
+    byte *data = gs_alloc_bytes(mem, raster * (r.q.y - r.p.y), "clist_save_rect");
+    int code;
+
+    if (data == NULL)
+        return_error(gs_error_VMerror);
+    params.options = GB_COLORS_NATIVE | GB_ALPHA_NONE | GB_DEPTH_ALL |
+                     GB_PACKING_CHUNKY | GB_RETURN_COPY | GB_ALIGN_STANDARD |
+                     GB_OFFSET_0 | GB_RASTER_STANDARD;
+    params.data[0] = data;
+    code = dev_proc(bdev, get_bits_rectangle)(bdev, &r, &params, NULL);
+    if (code < 0) {
+        gs_free_object(mem, data, "clist_save_rect");
+        return code;
+    }
+    *pdata = data;
+    *praster = raster;
+    return 0;
+}
+
 /*
  * Render a rectangle to a client-supplied device.  There is no necessary
  * relationship between band boundaries and the region being rendered.
@@ -799,7 +828,9 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
 
     for (i = 0; i < num_pages && code >= 0; ++i) {
         bool pdf14_needed = false;
-        int band;
+        bool split, trans_pattern = false;
+        gs_int_rect trans_rect;
+        int band, x0;
 
         if (ppages == NULL) {
                 /*
@@ -847,16 +878,78 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
         /* with the pdf14 compositor info that was written to the clist: colorspace, */
         /* colorspace, etc.                                                          */
         pdf14_needed = !pdf14_ok_to_optimize(bdev);
-        for (band=band_first; !pdf14_needed && band <= band_last; band++)
-            pdf14_needed |= (crdev->color_usage_array[band].trans_bbox.p.y <=
-            crdev->color_usage_array[band].trans_bbox.q.y) ? true : false;
-
-        code = clist_playback_file_bands(pdf14_needed ?
-                                         playback_action_render : playback_action_render_no_pdf14,
-                                         crdev, pinfo,
-                                         bdev, band_first, band_last,
-                                         prect->p.x - bdev->band_offset_x,
-                                         prect->p.y);
+        x0 = prect->p.x - bdev->band_offset_x;
+        split = false;
+        if (!pdf14_needed) {
+            /* Gather the trans_bbox of the bands into band buffer coordinates */
+            trans_rect.p.x = trans_rect.p.y = max_int;
+            trans_rect.q.x = trans_rect.q.y = min_int;
+            for (band=band_first; band <= band_last; band++) {
+                const gs_int_rect *bbox = &crdev->color_usage_array[band].trans_bbox;
+                int band_y = band * band_height - prect->p.y;
+
+                if (bbox->p.y > bbox->q.y)
+                    continue;
+                pdf14_needed = true;
+                trans_pattern |= crdev->color_usage_array[band].trans_pattern;
+                trans_rect.p.x = min(trans_rect.p.x, bbox->p.x - x0);
+                trans_rect.q.x = max(trans_rect.q.x, bbox->q.x + 1 - x0);
+                trans_rect.p.y = min(trans_rect.p.y, bbox->p.y + band_y);
+                trans_rect.q.y = max(trans_rect.q.y, bbox->q.y + 1 + band_y);
+            }
+            if (pdf14_needed) {
+                int width = prect->q.x - prect->p.x;
+                int height = prect->q.y - prect->p.y;
+
+                trans_rect.p.x = max(trans_rect.p.x, 0);
+                trans_rect.p.y = max(trans_rect.p.y, 0);
+                trans_rect.q.x = min(trans_rect.q.x, width);
+                trans_rect.q.y = min(trans_rect.q.y, height);
+                /* If transparency only touches a small part of the bands, it */
+                /* is cheaper to composite just that part and render the rest */
+                /* without the compositor, than to composite everything.      */
+                /* Transparent pattern fills can't be drawn without it though, */
+                /* and with tags the compositor also sets the tag of pixels   */
+                /* outside the rectangle.                                     */
+                split = !bdev->is_planar && !device_encodes_tags(bdev) && !trans_pattern &&
+                    trans_rect.p.x < trans_rect.q.x && trans_rect.p.y < trans_rect.q.y &&
+                    (int64_t)(trans_rect.q.x - trans_rect.p.x) * (trans_rect.q.y - trans_rect.p.y) * 2 <=
+                    (int64_t)width * height;
+            }
+        }
+
+        if (split) {
+            /* Composite just the transparent area first, and keep the result */
+            /* of that while the bands are redone without the compositor.     */
+            byte *saved = NULL;
+            uint raster = 0;
+
+            crdev->trans_rect = trans_rect;
+            code = clist_playback_file_bands(playback_action_render,
+                                             crdev, pinfo,
+                                             bdev, band_first, band_last,
+                                             x0, prect->p.y);
+            crdev->trans_rect.p.x = crdev->trans_rect.p.y = 0;
+            crdev->trans_rect.q.x = crdev->trans_rect.q.y = 0;
+            if (code >= 0)
+                code = clist_save_rect(bdev, &trans_rect, &saved, &raster, crdev->memory);
+            if (code >= 0)
+                code = clist_playback_file_bands(playback_action_render_no_pdf14,
+                                                 crdev, pinfo,
+                                                 bdev, band_first, band_last,
+                                                 x0, prect->p.y);
+            if (code >= 0)
+                code = dev_proc(bdev, copy_color)(bdev, saved, 0, raster, gx_no_bitmap_id,
+                                                  trans_rect.p.x, trans_rect.p.y,
+                                                  trans_rect.q.x - trans_rect.p.x,
+                                                  trans_rect.q.y - trans_rect.p.y);
+            gs_free_object(crdev->memory, saved, "clist_render_rectangle");
+        } else
+            code = clist_playback_file_bands(pdf14_needed ?
+                                             playback_action_render : playback_action_render_no_pdf14,
+                                             crdev, pinfo,
+                                             bdev, band_first, band_last,
+                                             x0, prect->p.y);
     }
     crdev->icc_struct->pageneutralcolor = save_pageneutralcolor;	/* restore it */
     return code;
@@ -352,6 +352,14 @@ enum {
      * the PDF font may not match the widths of the glyphs in the font.
      */
     gxdso_event_info,
+    /* gxdso_pdf14_smask_cached:
+     *     data = NULL
+     *     size = 0
+     * Returns 1 if the soft mask that has just been begun will be copied
+     * from the pdf14 device's cache of finished masks, so there is no need
+     * to draw its content, 0 otherwise.
+     */
+    gxdso_pdf14_smask_cached,
 
     /* Debug only dsos follow here */
 #ifdef DEBUG
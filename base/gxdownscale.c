@@ -19,6 +19,7 @@
 #include "string_.h"
 #include "gdevprn.h"
 #include "assert_.h"
+#include "gxsync.h"
 
 #ifdef WITH_CAL
 #include "cal_ets.h"
@@ -2535,9 +2536,141 @@ gx_downscaler_init_trapped_cm_halftone(gx_downscaler_t    *ds,
     return code;
 }
 
+struct gx_downscaler_thread_s
+{
+    gx_downscaler_t *ds;
+    gp_thread_id     thread;
+    gx_semaphore_t  *start;
+    gx_semaphore_t  *done;
+    int              first_plane; /* Planes first_plane, first_plane + step, ... */
+    int              quit;
+    /* The current row, valid between start and done */
+    byte           **out;
+    byte           **in;
+    int              row;
+    int              span;
+};
+
+static void
+downscale_planes(gx_downscaler_t *ds, byte **out, byte **in, int row,
+                 int span, int first_plane, int step)
+{
+    int plane;
+
+    for (plane = first_plane; plane < ds->num_planes; plane += step)
+        (ds->down_core)(ds, out[plane], in[plane], row, plane, span);
+}
+
+static void
+downscaler_thread(void *arg)
+{
+    gx_downscaler_thread_t *thread = (gx_downscaler_thread_t *)arg;
+
+    for (;;) {
+        gx_semaphore_wait(thread->start);
+        if (thread->quit)
+            break;
+        downscale_planes(thread->ds, thread->out, thread->in, thread->row,
+                         thread->span, thread->first_plane,
+                         thread->ds->num_threads + 1);
+        gx_semaphore_signal(thread->done);
+    }
+}
+
+/* Downscale all the planes of a row, sharing them out among the
+ * worker threads (if any). */
+static void
+downscale_row_planes(gx_downscaler_t *ds, byte **out, byte **in, int row,
+                     int span)
+{
+    int i;
+
+    for (i = 0; i < ds->num_threads; i++) {
+        gx_downscaler_thread_t *thread = &ds->threads[i];
+
+        thread->out = out;
+        thread->in = in;
+        thread->row = row;
+        thread->span = span;
+        gx_semaphore_signal(thread->start);
+    }
+    /* The calling thread takes plane 0 and every (num_threads+1)th after */
+    downscale_planes(ds, out, in, row, span, 0, ds->num_threads + 1);
+    for (i = 0; i < ds->num_threads; i++)
+        gx_semaphore_wait(ds->threads[i].done);
+}
+
+static void
+stop_threads(gx_downscaler_t *ds)
+{
+    gs_memory_t *mem;
+    int i;
+
+    if (ds->threads == NULL)
+        return;
+    mem = ds->dev->memory->non_gc_memory;
+    for (i = 0; i < ds->num_threads; i++) {
+        gx_downscaler_thread_t *thread = &ds->threads[i];
+
+        thread->quit = 1;
+        gx_semaphore_signal(thread->start);
+        gp_thread_finish(thread->thread);
+        gx_semaphore_free(thread->start);
+        gx_semaphore_free(thread->done);
+    }
+    gs_free_object(mem, ds->threads, "gx_downscaler(threads)");
+    ds->threads = NULL;
+    ds->num_threads = 0;
+}
+
+int gx_downscaler_set_threads(gx_downscaler_t *ds, int num_threads)
+{
+    gs_memory_t *mem = ds->dev->memory->non_gc_memory;
+    int i;
+
+    stop_threads(ds);
+    /* Only the error diffusion cores are worth the synchronisation. */
+    if (ds->num_planes < 2 || ds->errors == NULL || ds->down_core == NULL)
+        return 0;
+    if (num_threads > ds->num_planes - 1)
+        num_threads = ds->num_planes - 1;
+    if (num_threads < 1)
+        return 0;
+
+    ds->threads = (gx_downscaler_thread_t *)
+        gs_alloc_byte_array(mem, num_threads, sizeof(gx_downscaler_thread_t),
+                            "gx_downscaler(threads)");
+    if (ds->threads == NULL)
+        return_error(gs_error_VMerror);
+    memset(ds->threads, 0, num_threads * sizeof(gx_downscaler_thread_t));
+    for (i = 0; i < num_threads; i++) {
+        gx_downscaler_thread_t *thread = &ds->threads[i];
+
+        thread->ds = ds;
+        thread->first_plane = i + 1;
+        thread->start = gx_semaphore_label(gx_semaphore_alloc(mem), "downscaler start");
+        thread->done = gx_semaphore_label(gx_semaphore_alloc(mem), "downscaler done");
+        if (thread->start == NULL || thread->done == NULL ||
+            gp_thread_start(downscaler_thread, thread, &thread->thread) < 0) {
+            /* Make do with the threads we have (we may be on a platform
+             * without threads). */
+            gx_semaphore_free(thread->start);
+            gx_semaphore_free(thread->done);
+            break;
+        }
+        gp_thread_label(thread->thread, "Downscaler");
+        ds->num_threads = i + 1;
+    }
+    /* Threads step through the planes by ds->num_threads+1, so this
+     * still covers every plane if we got fewer threads than asked for. */
+    return 0;
+}
+
 void gx_downscaler_fin(gx_downscaler_t *ds)
 {
     int plane;
+
+    stop_threads(ds);
     for (plane=0; plane < GS_CLIENT_COLOR_MAX_COMPONENTS; plane++) {
         gs_free_object(ds->dev->memory, ds->pre_cm[plane],
                        "gx_downscaler(planar_data)");
@@ -2748,15 +2881,12 @@ int gx_downscaler_get_bits_rectangle(gx_downscaler_t      *ds,
 
     if (upfactor > 1) {
         /* Downscale the block of lines into our output buffer */
-        for (plane=0; plane < ds->num_planes; plane++) {
-            byte *scaled = ds->scaled_data + upfactor * plane * ds->scaled_span;
-            (ds->down_core)(ds, scaled, params2.data[plane], row, plane, params2.raster);
-            params->data[plane] = scaled;
-        }
+        for (plane=0; plane < ds->num_planes; plane++)
+            params->data[plane] = ds->scaled_data + upfactor * plane * ds->scaled_span;
+        downscale_row_planes(ds, params->data, params2.data, row, params2.raster);
     } else if (ds->down_core != NULL) {
         /* Downscale direct into output buffer */
-        for (plane=0; plane < ds->num_planes; plane++)
-            (ds->down_core)(ds, params->data[plane], params2.data[plane], row, plane, params2.raster);
+        downscale_row_planes(ds, params->data, params2.data, row, params2.raster);
     } else {
         /* Copy into output buffer */
         /* No color management can be required here */
@@ -61,6 +61,9 @@ typedef struct gx_downscaler_ht_s
 
 typedef struct gx_downscaler_s gx_downscaler_t;
 
+/* Private worker thread state, see gx_downscaler_set_threads */
+typedef struct gx_downscaler_thread_s gx_downscaler_thread_t;
+
 /* Private function type for the core downscaler routines */
 typedef void (gx_downscale_core)(gx_downscaler_t *ds,
                                  byte            *out_buffer,
@@ -107,6 +110,9 @@ struct gx_downscaler_s {
     byte                 *htrow_alloc;
     byte                 *inbuf;
     byte                 *inbuf_alloc;
+
+    int                   num_threads;/* Extra threads for planar error diffusion */
+    gx_downscaler_thread_t *threads;
 };
 
 /* To use the downscaler:
@@ -304,6 +310,16 @@ int gx_downscaler_init_planar_trapped_cm(gx_downscaler_t      *ds,
                                          void                 *apply_cm_arg,
                                          int                   post_cm_num_comps);
 
+/* Planar error diffusion keeps separate state for each plane, so the
+ * planes of a row can be diffused in parallel. This starts up to
+ * num_threads extra threads to do so, in addition to the calling one.
+ * Call after gx_downscaler_init_planar*. It does nothing (and returns 0)
+ * if num_threads < 1, or if the downscaler isn't diffusing planar data.
+ * If threads can't be started, fewer (or none) are used. Output is
+ * identical whatever the number of threads.
+ */
+int gx_downscaler_set_threads(gx_downscaler_t *ds, int num_threads);
+
 int gx_downscaler_getbits(gx_downscaler_t *ds,
                           byte            *out_data,
                           int              row);
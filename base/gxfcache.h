@@ -66,6 +66,7 @@ struct cached_fm_pair_s {
     gx_ttfReader *ttr;		/* True Type interpreter data. */
     bool design_grid;           /* A charpath font face.  */
     uint prev, next;            /* list of pairs. */
+    ulong lookups, hits;	/* character cache statistics */
 };
 
 #define private_st_cached_fm_pair() /* in gxccman.c */\
@@ -219,6 +220,17 @@ typedef struct char_cache_s {
     uint upper;			/* max size of a single cached char */
     gs_glyph_mark_proc_t mark_glyph;
     void *mark_glyph_data;	/* closure data */
+    /*
+     * When the cache is full and recent lookups miss often, bmax grows
+     * by a chunk at a time up to bmax_target; the hash table is sized
+     * for bmax_target from the start.
+     */
+    uint bmax_target;
+    uint grows;			/* # of times bmax was raised */
+    ulong lookups, hits;	/* statistics, see gs_cachestats */
+    ulong additions, evictions;
+    ulong adapt_lookups;	/* lookups and hits at the last */
+    ulong adapt_hits;		/* adaptive sizing decision */
 } char_cache;
 
 /* ------ Font/character cache ------ */
@@ -260,6 +272,8 @@ struct gs_font_dir_s {
     gx_ttfMemory *ttm;
     /* User parameter GridFitTT. */
     uint grid_fit_tt;
+    /* User parameter SubpixelPhases (0 = as implied by oversampling). */
+    uint subpixel_phases;
     gx_device_spot_analyzer *san;
     int (*global_glyph_code)(const gs_memory_t *mem, gs_const_string *gstr, gs_glyph *pglyph);
     ulong text_enum_id; /* debug purpose only. */
@@ -278,8 +292,8 @@ struct gs_font_dir_s {
 
 /* Character cache procedures (in gxccache.c and gxccman.c) */
 int gx_char_cache_alloc(gs_memory_t * struct_mem, gs_memory_t * bits_mem,
-                        gs_font_dir * pdir, uint bmax, uint mmax,
-                        uint cmax, uint upper);
+                        gs_font_dir * pdir, uint bmax, uint bmax_target,
+                        uint mmax, uint cmax, uint upper);
 int gx_char_cache_init(gs_font_dir *);
 void gx_purge_selected_cached_chars(gs_font_dir *,
                                     bool(*)(const gs_memory_t *, cached_char *, void *), void *);
@@ -86,6 +86,14 @@ typedef struct gx_code_space_s {
 typedef struct gx_code_map_s {
     gx_cmap_lookup_range_t *lookup;
     int num_lookup;
+    /*
+     * Optional index of the lookup ranges by the first byte of a code.
+     * The first 257 elements are offsets into the rest: the ranges that
+     * can match a code starting with byte c are listed, in the order the
+     * decoder tries them, from index[257 + index[c]] up to (but not
+     * including) index[257 + index[c + 1]].  0 means scan all ranges.
+     */
+    uint *index;
 } gx_code_map_t;
 struct gs_cmap_adobe1_s {
     GS_CMAP_COMMON;
@@ -98,10 +106,11 @@ struct gs_cmap_adobe1_s {
 
 extern_st(st_cmap_adobe1);
 #define public_st_cmap_adobe1()	/* in gsfcmap1.c */\
-  gs_public_st_suffix_add4(st_cmap_adobe1, gs_cmap_adobe1_t,\
+  gs_public_st_suffix_add6(st_cmap_adobe1, gs_cmap_adobe1_t,\
     "gs_cmap_adobe1_t", cmap_adobe1_enum_ptrs, cmap_adobe1_reloc_ptrs,\
     st_cmap,\
-    code_space.ranges, def.lookup, notdef.lookup, mark_glyph_data)
+    code_space.ranges, def.lookup, notdef.lookup, mark_glyph_data,\
+    def.index, notdef.index)
 
 /* ---------------- Procedures ---------------- */
 
@@ -115,4 +124,10 @@ int gs_cmap_adobe1_alloc(gs_cmap_adobe1_t **ppcmap, int wmode,
                          uint keys_size, uint values_size,
                          const gs_cid_system_info_t *pcidsi, gs_memory_t *mem);
 
+/*
+ * Build the first byte index for a code map whose lookup ranges have
+ * been filled in.  Small maps are left unindexed.
+ */
+int gs_cmap_adobe1_index_code_map(gx_code_map_t *pcmap, gs_memory_t *mem);
+
 #endif /* gxfcmap1_INCLUDED */
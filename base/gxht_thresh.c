@@ -71,6 +71,25 @@ static const byte bitreverse[] =
   0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
   0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF,
   0x3F, 0xBF, 0x7F, 0xFF};
+
+/* Wider kernels for x86. These are compiled for their own instruction set
+   only (via the target attribute), and are selected at run time if the CPU
+   supports them, so that the build still runs on plain SSE2 machines. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HT_THRESH_AVX
+#include <immintrin.h>
+#endif
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+/* NEON is always present on AArch64, so no run time check is needed. */
+#define HT_THRESH_NEON
+#include <arm_neon.h>
+
+#endif
+
+#if defined(HAVE_SSE2) || defined(HT_THRESH_NEON)
+#define HT_THRESH_SIMD
 #endif
 
 #if RAW_HT_DUMP
@@ -102,7 +121,7 @@ gx_ht_threshold_row_byte(byte *contone, byte *threshold_strip, int contone_strid
 }
 #endif
 
-#ifndef HAVE_SSE2
+#ifndef HT_THRESH_SIMD
 /* A simple case for use in the landscape mode. Could probably be coded up
    faster */
 static void
@@ -122,7 +141,7 @@ threshold_16_bit(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
         *ht_data++ = h;
     }
 }
-#else
+#elif defined(HAVE_SSE2)
 /* Note this function has strict data alignment needs */
 static void
 threshold_16_SSE(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
@@ -176,9 +195,149 @@ threshold_16_SSE_unaligned(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
     ht_data[0] = bitreverse[sse_data[0]];
     ht_data[1] = bitreverse[sse_data[1]];
 }
+
+#define threshold_16_simd threshold_16_SSE
+#define threshold_16_simd_unaligned threshold_16_SSE_unaligned
+
+#ifdef HT_THRESH_AVX
+/* Byte shuffle reversing each group of 8 bytes. Applied before taking the
+   sign (or comparison) mask, it puts the leftmost pixel of each 8 into the
+   most significant bit of its output byte, so no bitreverse lookup is
+   needed. */
+#define HT_REVERSE_8_BYTES 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+
+/* 32 pixels at a time. No alignment requirement. */
+__attribute__((target("avx2")))
+static void
+threshold_32_AVX2(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
+{
+    __m256i input1;
+    __m256i input2;
+    uint32_t result;
+    const __m256i sign_fix = _mm256_set1_epi8((char)0x80);
+    const __m256i reverse = _mm256_setr_epi8(HT_REVERSE_8_BYTES,
+                                             HT_REVERSE_8_BYTES);
+
+    /* Load */
+    input1 = _mm256_loadu_si256((const __m256i *)contone_ptr);
+    input2 = _mm256_loadu_si256((const __m256i *)thresh_ptr);
+    /* As for SSE2, use the signed saturated subtraction */
+    input1 = _mm256_xor_si256(input1, sign_fix);
+    input2 = _mm256_xor_si256(input2, sign_fix);
+    input2 = _mm256_subs_epi8(input1, input2);
+    /* Reverse the bytes within each 8, then grab the sign mask */
+    input2 = _mm256_shuffle_epi8(input2, reverse);
+    result = (uint32_t)_mm256_movemask_epi8(input2);
+    ht_data[0] = (byte)result;
+    ht_data[1] = (byte)(result >> 8);
+    ht_data[2] = (byte)(result >> 16);
+    ht_data[3] = (byte)(result >> 24);
+}
+
+/* 64 pixels at a time. No alignment requirement. */
+__attribute__((target("avx512bw")))
+static void
+threshold_64_AVX512(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
+{
+    __m512i input1;
+    __m512i input2;
+    uint64_t result;
+    int k;
+    const __m512i reverse = _mm512_set4_epi32(0x08090a0b, 0x0c0d0e0f,
+                                              0x00010203, 0x04050607);
+
+    /* Load, reverse the bytes within each 8, and compare unsigned */
+    input1 = _mm512_loadu_si512((const void *)contone_ptr);
+    input2 = _mm512_loadu_si512((const void *)thresh_ptr);
+    input1 = _mm512_shuffle_epi8(input1, reverse);
+    input2 = _mm512_shuffle_epi8(input2, reverse);
+    result = (uint64_t)_mm512_cmplt_epu8_mask(input1, input2);
+    for (k = 0; k < 8; k++)
+        ht_data[k] = (byte)(result >> (8 * k));
+}
+
+/* 0 for plain SSE2, 1 for AVX2, 2 for AVX-512. */
+static int
+threshold_simd_level(void)
+{
+    /* Racing threads will all store the same value. */
+    static int level = -1;
+
+    if (level < 0) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512bw"))
+            level = 2;
+        else if (__builtin_cpu_supports("avx2"))
+            level = 1;
+        else
+            level = 0;
+    }
+    return level;
+}
+#endif /* HT_THRESH_AVX */
+
+#elif defined(HT_THRESH_NEON)
+/* No alignment requirement. */
+static void
+threshold_16_NEON(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
+{
+    static const byte bit_weights[16] =
+        { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+          0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    uint8x16_t less;
+
+    /* All ones where contone < threshold, weighted by the bit position
+       and summed across each half. */
+    less = vcltq_u8(vld1q_u8(contone_ptr), vld1q_u8(thresh_ptr));
+    less = vandq_u8(less, vld1q_u8(bit_weights));
+    ht_data[0] = vaddv_u8(vget_low_u8(less));
+    ht_data[1] = vaddv_u8(vget_high_u8(less));
+}
+
+#define threshold_16_simd threshold_16_NEON
+#define threshold_16_simd_unaligned threshold_16_NEON
+#endif
+
+#ifdef HT_THRESH_SIMD
+/* Threshold num_tiles consecutive sets of 16 pixels, setting the bit
+   for each pixel where contone < thresh. The widest kernel the CPU
+   supports is used. Alignment as for threshold_16_SSE. */
+static void
+threshold_tiles(byte *contone_ptr, byte *thresh_ptr, byte *ht_data,
+                int num_tiles)
+{
+#ifdef HT_THRESH_AVX
+    if (num_tiles >= 2) {
+        int level = threshold_simd_level();
+
+        if (level >= 2) {
+            for (; num_tiles >= 4; num_tiles -= 4) {
+                threshold_64_AVX512(contone_ptr, thresh_ptr, ht_data);
+                thresh_ptr += 64;
+                contone_ptr += 64;
+                ht_data += 8;
+            }
+        }
+        if (level >= 1) {
+            for (; num_tiles >= 2; num_tiles -= 2) {
+                threshold_32_AVX2(contone_ptr, thresh_ptr, ht_data);
+                thresh_ptr += 32;
+                contone_ptr += 32;
+                ht_data += 4;
+            }
+        }
+    }
+#endif
+    for (; num_tiles > 0; num_tiles--) {
+        threshold_16_simd(contone_ptr, thresh_ptr, ht_data);
+        thresh_ptr += 16;
+        contone_ptr += 16;
+        ht_data += 2;
+    }
+}
 #endif
 
-/* SSE2 and non-SSE2 implememntation of thresholding a row. Subtractive case
+/* SIMD and non-SIMD implememntation of thresholding a row. Subtractive case
    There is some code replication between the two of these (additive and subtractive)
    that I need to go back and determine how we can combine them without
    any performance loss. */
@@ -187,7 +346,7 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
                   byte *halftone, int dithered_stride, int width,
                   int num_rows, int offset_bits)
 {
-#ifndef HAVE_SSE2
+#ifndef HT_THRESH_SIMD
     int k, j;
     byte *contone_ptr;
     byte *thresh_ptr;
@@ -252,7 +411,7 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
     byte *thresh_ptr;
     byte *halftone_ptr;
     int num_tiles = (width - offset_bits + 15)>>4;
-    int k, j;
+    int j;
 
     for (j = 0; j < num_rows; j++) {
         /* contone and thresh_ptr are 128 bit aligned.  We do need to do this in
@@ -267,32 +426,27 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
                requires 128 bit alignment.  contone_ptr and thresh_ptr
                are set up so that after we move in by offset_bits elements
                then we are 128 bit aligned.  */
-            threshold_16_SSE_unaligned(thresh_ptr, contone_ptr,
-                                       halftone_ptr);
+            threshold_16_simd_unaligned(thresh_ptr, contone_ptr,
+                                        halftone_ptr);
             halftone_ptr += 2;
             thresh_ptr += offset_bits;
             contone_ptr += offset_bits;
         }
         /* Now we should have 128 bit aligned with our input data. Iterate
-           over sets of 16 going directly into our HT buffer.  Sources and
+           over sets of 16 (or more) going directly into our HT buffer.  Sources and
            halftone_ptr buffers should be padded to allow 15 bit overrun */
-        for (k = 0; k < num_tiles; k++) {
-            threshold_16_SSE(thresh_ptr, contone_ptr, halftone_ptr);
-            thresh_ptr += 16;
-            contone_ptr += 16;
-            halftone_ptr += 2;
-        }
+        threshold_tiles(thresh_ptr, contone_ptr, halftone_ptr, num_tiles);
     }
 #endif
 }
 
-/* SSE2 and non-SSE2 implememntation of thresholding a row. additive case  */
+/* SIMD and non-SIMD implememntation of thresholding a row. additive case  */
 void
 gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stride,
                   byte *halftone, int dithered_stride, int width,
                   int num_rows, int offset_bits)
 {
-#ifndef HAVE_SSE2
+#ifndef HT_THRESH_SIMD
     int k, j;
     byte *contone_ptr;
     byte *thresh_ptr;
@@ -357,7 +511,7 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
     byte *thresh_ptr;
     byte *halftone_ptr;
     int num_tiles = (width - offset_bits + 15)>>4;
-    int k, j;
+    int j;
 
     for (j = 0; j < num_rows; j++) {
         /* contone and thresh_ptr are 128 bit aligned.  We do need to do this in
@@ -372,21 +526,16 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
                requires 128 bit alignment.  contone_ptr and thresh_ptr
                are set up so that after we move in by offset_bits elements
                then we are 128 bit aligned.  */
-            threshold_16_SSE_unaligned(contone_ptr, thresh_ptr,
-                                       halftone_ptr);
+            threshold_16_simd_unaligned(contone_ptr, thresh_ptr,
+                                        halftone_ptr);
             halftone_ptr += 2;
             thresh_ptr += offset_bits;
             contone_ptr += offset_bits;
         }
         /* Now we should have 128 bit aligned with our input data. Iterate
-           over sets of 16 going directly into our HT buffer.  Sources and
+           over sets of 16 (or more) going directly into our HT buffer.  Sources and
            halftone_ptr buffers should be padded to allow 15 bit overrun */
-        for (k = 0; k < num_tiles; k++) {
-            threshold_16_SSE(contone_ptr, thresh_ptr, halftone_ptr);
-            thresh_ptr += 16;
-            contone_ptr += 16;
-            halftone_ptr += 2;
-        }
+        threshold_tiles(contone_ptr, thresh_ptr, halftone_ptr, num_tiles);
     }
 #endif
 }
@@ -461,15 +610,17 @@ gx_ht_threshold_landscape_sub(byte *contone_align, byte *thresh_align,
         /* Now we have our left justified and expanded contone data for
            LAND_BITS/16 sets of 16 bits. Go ahead and threshold these. */
         contone_ptr = &contone[0];
+#ifdef HT_THRESH_SIMD
+        threshold_tiles(thresh_ptr, contone_ptr, halftone_ptr, LAND_BITS>>4);
+        thresh_ptr += LAND_BITS;
+        position += LAND_BITS;
+        halftone_ptr += LAND_BITS>>3;
+#else
 #if LAND_BITS > 16
         j = LAND_BITS;
         do {
 #endif
-#ifdef HAVE_SSE2
-            threshold_16_SSE(thresh_ptr, contone_ptr, halftone_ptr);
-#else
             threshold_16_bit(thresh_ptr, contone_ptr, halftone_ptr);
-#endif
             thresh_ptr += 16;
             position += 16;
             halftone_ptr += 2;
@@ -477,6 +628,7 @@ gx_ht_threshold_landscape_sub(byte *contone_align, byte *thresh_align,
 #if LAND_BITS > 16
             j -= 16;
         } while (j > 0);
+#endif
 #endif
     }
 }
@@ -552,15 +704,17 @@ gx_ht_threshold_landscape(byte *contone_align, byte *thresh_align,
         /* Now we have our left justified and expanded contone data for
            LAND_BITS/16 sets of 16 bits. Go ahead and threshold these. */
         contone_ptr = &contone[0];
+#ifdef HT_THRESH_SIMD
+        threshold_tiles(contone_ptr, thresh_ptr, halftone_ptr, LAND_BITS>>4);
+        thresh_ptr += LAND_BITS;
+        position += LAND_BITS;
+        halftone_ptr += LAND_BITS>>3;
+#else
 #if LAND_BITS > 16
         j = LAND_BITS;
         do {
 #endif
-#ifdef HAVE_SSE2
-            threshold_16_SSE(contone_ptr, thresh_ptr, halftone_ptr);
-#else
             threshold_16_bit(contone_ptr, thresh_ptr, halftone_ptr);
-#endif
             thresh_ptr += 16;
             position += 16;
             halftone_ptr += 2;
@@ -568,6 +722,7 @@ gx_ht_threshold_landscape(byte *contone_align, byte *thresh_align,
 #if LAND_BITS > 16
             j -= 16;
         } while (j > 0);
+#endif
 #endif
     }
 }
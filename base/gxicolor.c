@@ -559,19 +559,24 @@ image_color_icc_prep(gx_image_enum *penum_orig, const byte *psrc, uint w,
                     decode_row_cie(penum, psrc, spp, psrc_decode,
                                     psrc_decode+w, get_cie_range(penum->pcs));
                 }
-                (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                    &input_buff_desc,
-                                                    &output_buff_desc,
-                                                    (void*) psrc_decode,
-                                                    (void*) *psrc_cm);
+                code = gx_image_map_buffer(penum_orig, dev,
+                                           &input_buff_desc,
+                                           &output_buff_desc,
+                                           (void*) psrc_decode,
+                                           (void*) *psrc_cm);
                 gs_free_object(pgs->memory, psrc_decode, "image_color_icc_prep");
             } else {
                 /* CM only. No decode */
-                (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                    &input_buff_desc,
-                                                    &output_buff_desc,
-                                                    (void*) psrc,
-                                                    (void*) *psrc_cm);
+                code = gx_image_map_buffer(penum_orig, dev,
+                                           &input_buff_desc,
+                                           &output_buff_desc,
+                                           (void*) psrc,
+                                           (void*) *psrc_cm);
+            }
+            if (code < 0) {
+                gs_free_object(pgs->memory, *psrc_cm_start, "image_color_icc_prep");
+                *psrc_cm_start = NULL;
+                return code;
             }
         }
     }
@@ -501,6 +501,7 @@ gx_image1_end_image(gx_image_enum_common_t * info, bool draw_last)
         (*scaler->templat->release) ((stream_state *) scaler);
         gs_free_object(mem, scaler, "image scaler state");
     }
+    gx_image_free_cm_threads(penum);
     if (penum->icc_link != NULL) {
         gsicc_release_link(penum->icc_link);
     }
@@ -155,6 +155,9 @@ typedef struct gx_image_color_cache_s {
 
 typedef struct gx_device_rop_texture_s gx_device_rop_texture;
 
+/* Worker threads for colour converting wide rows, private to gxipixel.c */
+typedef struct gx_image_cm_threads_s gx_image_cm_threads;
+
 typedef struct gx_image_icc_setup_s {
     bool need_decode; /* used in icc processing */
     bool is_lab; /* used in icc processing */
@@ -298,6 +301,7 @@ struct gx_image_enum_s {
      * in place, but it's too much makefile upheaval to only have
      * it here in CAL builds, so we live with it in all builds. */
     void *cal_ht;   /* CAL halftone state pointer */
+    gx_image_cm_threads *cm_threads; /* Non-GC, see gx_image_map_buffer */
 };
 
 /* Enumerate the pointers in an image enumerator. */
@@ -365,4 +369,16 @@ image_init_clues(gx_image_enum * penum, int bps, int spp);
    values right away */
 int
 image_init_color_cache(gx_image_enum * penum, int bps, int spp);
+
+/* Colour convert a buffer through penum->icc_link.  Wide single rows are
+   split across worker threads if .setimagethreads asked for them. */
+int
+gx_image_map_buffer(gx_image_enum *penum, gx_device *dev,
+                    gsicc_bufferdesc_t *input_buff_desc,
+                    gsicc_bufferdesc_t *output_buff_desc,
+                    void *inputbuffer, void *outputbuffer);
+
+/* Stop and free any worker threads started by gx_image_map_buffer. */
+void
+gx_image_free_cm_threads(gx_image_enum *penum);
 #endif /* gximage_INCLUDED */
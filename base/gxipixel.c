@@ -18,6 +18,7 @@
 #include "gx.h"
 #include "math_.h"
 #include "memory_.h"
+#include "stdint_.h"
 #include "gpcheck.h"
 #include "gscdefs.h"            /* for image class table */
 #include "gserrors.h"
@@ -43,6 +44,8 @@
 #include "gsicc_cms.h"
 #include "gsicc_manage.h"
 #include "gxdevsop.h"
+#include "gxsync.h"
+#include "gsstate.h"
 
 /* Structure descriptors */
 private_st_gx_image_enum();
@@ -1286,6 +1289,209 @@ image_init_color_cache(gx_image_enum * penum, int bps, int spp)
     return 0;
 }
 
+/*
+ * Colour conversion of wide rows on worker threads.
+ *
+ * Converting a row through the CMM is a pixel by pixel operation, so a
+ * single row can be cut into pixel ranges that are converted at the same
+ * time.  The calling thread does the first range itself and waits for the
+ * rest, so rows still go out in order.  The threads are started on the
+ * first wide row of an image and kept until gx_image1_end_image.
+ *
+ * Only links using the lcms transform are split: other map_buffer procs
+ * may keep state between calls.  The lcms link builds a variant of its
+ * transform for each new buffer format the first time it sees it, and
+ * that can't be raced, so the first row in a format is done serially.
+ */
+
+/* Rows narrower than this aren't worth the threads. */
+#define IMAGE_CM_THREAD_MIN_PIXELS 2048
+
+typedef struct {
+    gp_thread_id        thread;
+    gx_semaphore_t     *start;
+    gx_semaphore_t     *done;
+    /* Set by the caller before start */
+    bool                quit;
+    gx_device          *dev;
+    gsicc_link_t       *link;
+    gsicc_bufferdesc_t  input_buff_desc;
+    gsicc_bufferdesc_t  output_buff_desc;
+    void               *inputbuffer;
+    void               *outputbuffer;
+    /* Set by the worker before done */
+    int                 code;
+} image_cm_thread_t;
+
+struct gx_image_cm_threads_s {
+    gs_memory_t        *memory;
+    int                 num_threads;  /* 0 if none could be started */
+    int                 format;       /* Last buffer format done serially */
+    image_cm_thread_t  *threads;
+};
+
+static void
+image_cm_thread(void *arg)
+{
+    image_cm_thread_t *thread = (image_cm_thread_t *)arg;
+
+    for (;;) {
+        gx_semaphore_wait(thread->start);
+        if (thread->quit)
+            break;
+        thread->code = (thread->link->procs.map_buffer)(thread->dev, thread->link,
+                                                        &thread->input_buff_desc,
+                                                        &thread->output_buff_desc,
+                                                        thread->inputbuffer,
+                                                        thread->outputbuffer);
+        gx_semaphore_signal(thread->done);
+    }
+}
+
+void
+gx_image_free_cm_threads(gx_image_enum *penum)
+{
+    gx_image_cm_threads *cmt = penum->cm_threads;
+    int i;
+
+    if (cmt == NULL)
+        return;
+    for (i = 0; i < cmt->num_threads; i++) {
+        image_cm_thread_t *thread = &cmt->threads[i];
+
+        thread->quit = true;
+        gx_semaphore_signal(thread->start);
+        gp_thread_finish(thread->thread);
+        gx_semaphore_free(thread->start);
+        gx_semaphore_free(thread->done);
+    }
+    gs_free_object(cmt->memory, cmt->threads, "gx_image_free_cm_threads");
+    gs_free_object(cmt->memory, cmt, "gx_image_free_cm_threads");
+    penum->cm_threads = NULL;
+}
+
+/* Get the worker threads for penum, starting them if need be.  Returns
+   NULL if rows are to be converted serially. */
+static gx_image_cm_threads *
+image_cm_threads(gx_image_enum *penum)
+{
+    gs_memory_t *mem = penum->memory->non_gc_memory;
+    gx_image_cm_threads *cmt = penum->cm_threads;
+    int num_threads, i;
+
+    if (cmt != NULL)
+        return cmt->num_threads > 0 ? cmt : NULL;
+    num_threads = gs_getimagethreads(penum->memory);
+    if (num_threads < 1 || penum->memory->thread_safe_memory == NULL)
+        return NULL;
+
+    cmt = (gx_image_cm_threads *)gs_alloc_bytes(mem, sizeof(gx_image_cm_threads),
+                                                "image_cm_threads");
+    if (cmt == NULL)
+        return NULL;
+    cmt->memory = mem;
+    cmt->num_threads = 0;
+    cmt->format = -1;
+    cmt->threads = (image_cm_thread_t *)gs_alloc_byte_array(mem, num_threads,
+                                            sizeof(image_cm_thread_t),
+                                            "image_cm_threads");
+    penum->cm_threads = cmt;
+    if (cmt->threads == NULL)
+        return NULL;
+    memset(cmt->threads, 0, num_threads * sizeof(image_cm_thread_t));
+    for (i = 0; i < num_threads; i++) {
+        image_cm_thread_t *thread = &cmt->threads[i];
+
+        thread->start = gx_semaphore_label(gx_semaphore_alloc(mem), "image cm start");
+        thread->done = gx_semaphore_label(gx_semaphore_alloc(mem), "image cm done");
+        if (thread->start == NULL || thread->done == NULL ||
+            gp_thread_start(image_cm_thread, thread, &thread->thread) < 0) {
+            /* Make do with the threads we have (we may be on a platform
+             * without threads). */
+            gx_semaphore_free(thread->start);
+            gx_semaphore_free(thread->done);
+            break;
+        }
+        gp_thread_label(thread->thread, "Image colour conversion");
+    }
+    cmt->num_threads = i;
+    return i > 0 ? cmt : NULL;
+}
+
+/* Narrow a single row buffer description down to pixels x0 to x1,
+   returning the offset of x0 in the buffer. */
+static int
+image_cm_sub_buffer(gsicc_bufferdesc_t *sub, const gsicc_bufferdesc_t *desc,
+                    int x0, int x1)
+{
+    *sub = *desc;
+    sub->pixels_per_row = x1 - x0;
+    return x0 * desc->bytes_per_chan * (desc->is_planar ? 1 : desc->num_chan);
+}
+
+int
+gx_image_map_buffer(gx_image_enum *penum, gx_device *dev,
+                    gsicc_bufferdesc_t *input_buff_desc,
+                    gsicc_bufferdesc_t *output_buff_desc,
+                    void *inputbuffer, void *outputbuffer)
+{
+    gsicc_link_t *link = penum->icc_link;
+    int width = input_buff_desc->pixels_per_row;
+    gx_image_cm_threads *cmt;
+    gsicc_bufferdesc_t input_sub, output_sub;
+    int format, parts, i, in_offset, out_offset, code;
+
+    if (link->procs.map_buffer != gscms_transform_color_buffer ||
+        input_buff_desc->num_rows != 1 || input_buff_desc->has_alpha ||
+        width < IMAGE_CM_THREAD_MIN_PIXELS ||
+        (cmt = image_cm_threads(penum)) == NULL)
+        return (link->procs.map_buffer)(dev, link, input_buff_desc,
+                                        output_buff_desc, inputbuffer,
+                                        outputbuffer);
+
+    format = input_buff_desc->bytes_per_chan |
+             (output_buff_desc->bytes_per_chan << 2) |
+             (input_buff_desc->is_planar << 4) |
+             (output_buff_desc->is_planar << 5) |
+             (input_buff_desc->little_endian << 6) |
+             (output_buff_desc->little_endian << 7);
+    if (format != cmt->format) {
+        cmt->format = format;
+        return (link->procs.map_buffer)(dev, link, input_buff_desc,
+                                        output_buff_desc, inputbuffer,
+                                        outputbuffer);
+    }
+
+    parts = cmt->num_threads + 1;
+    for (i = 1; i < parts; i++) {
+        image_cm_thread_t *thread = &cmt->threads[i - 1];
+        int x0 = (int)((int64_t)width * i / parts);
+        int x1 = (int)((int64_t)width * (i + 1) / parts);
+
+        in_offset = image_cm_sub_buffer(&thread->input_buff_desc,
+                                        input_buff_desc, x0, x1);
+        out_offset = image_cm_sub_buffer(&thread->output_buff_desc,
+                                         output_buff_desc, x0, x1);
+        thread->dev = dev;
+        thread->link = link;
+        thread->inputbuffer = (byte *)inputbuffer + in_offset;
+        thread->outputbuffer = (byte *)outputbuffer + out_offset;
+        gx_semaphore_signal(thread->start);
+    }
+    image_cm_sub_buffer(&input_sub, input_buff_desc, 0, width / parts);
+    image_cm_sub_buffer(&output_sub, output_buff_desc, 0, width / parts);
+    code = (link->procs.map_buffer)(dev, link, &input_sub, &output_sub,
+                                    inputbuffer, outputbuffer);
+    for (i = 0; i < cmt->num_threads; i++) {
+        image_cm_thread_t *thread = &cmt->threads[i];
+
+        gx_semaphore_wait(thread->done);
+        if (code >= 0 && thread->code < 0)
+            code = thread->code;
+    }
+    return code;
+}
+
 /* Export this for use by image_render_ functions */
 void
 image_init_clues(gx_image_enum * penum, int bps, int spp)
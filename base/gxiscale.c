@@ -2170,9 +2170,14 @@ image_render_interpolate_icc(gx_image_enum * penum, const byte * buffer,
                           1, width_in);
             /* Do the transformation */
             psrc = (byte*) (stream_r.ptr + 1);
-            (penum->icc_link->procs.map_buffer)(dev, penum->icc_link, &input_buff_desc,
-                                                &output_buff_desc, (void*) psrc,
-                                                (void*) p_cm_buff);
+            code = gx_image_map_buffer(penum, dev, &input_buff_desc,
+                                       &output_buff_desc, (void*) psrc,
+                                       (void*) p_cm_buff);
+            if (code < 0) {
+                gs_free_object(pgs->memory, p_cm_buff,
+                               "image_render_interpolate_icc");
+                return code;
+            }
             /* Re-set the reading stream to use the cm data */
             stream_r.ptr = p_cm_buff - 1;
             stream_r.limit = stream_r.ptr + num_bytes_decode * width_in * spp_cm;
@@ -2228,15 +2233,17 @@ image_render_interpolate_icc(gx_image_enum * penum, const byte * buffer,
                     pinterp += (pss->params.LeftMarginOut / abs_interp_limit) * spp_decode;
                     p_cm_interp = (unsigned short *) p_cm_buff;
                     p_cm_interp += (pss->params.LeftMarginOut / abs_interp_limit) * spp_cm;
-                    (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                        &input_buff_desc,
-                                                        &output_buff_desc,
-                                                        (void*) pinterp,
-                                                        (void*) p_cm_interp);
+                    code = gx_image_map_buffer(penum, dev,
+                                               &input_buff_desc,
+                                               &output_buff_desc,
+                                               (void*) pinterp,
+                                               (void*) p_cm_interp);
+                    if (code < 0)
+                        break;
                 }
                 code = irii_core(penum, xo, xe, spp_cm, p_cm_interp, dev, abs_interp_limit, bpp, raster, yo, dy, lop);
                 if (code < 0)
-                    return code;
+                    break;
 inactive:
                 penum->line_xy++;
                 if (abs_interp_limit > 1) {
@@ -2252,6 +2259,8 @@ inactive:
             gs_free_object(pgs->memory, (byte *)p_cm_buff,
                            "image_render_interpolate_icc");
         }
+        if (code < 0)
+            return code;
     }
     return (h == 0 ? 0 : 1);
 }
@@ -2656,9 +2665,14 @@ image_render_interpolate_landscape_icc(gx_image_enum * penum,
                           1, width_in);
             /* Do the transformation */
             psrc = (byte*) (stream_r.ptr + 1);
-            (penum->icc_link->procs.map_buffer)(dev, penum->icc_link, &input_buff_desc,
-                                                &output_buff_desc, (void*) psrc,
-                                                (void*) p_cm_buff);
+            code = gx_image_map_buffer(penum, dev, &input_buff_desc,
+                                       &output_buff_desc, (void*) psrc,
+                                       (void*) p_cm_buff);
+            if (code < 0) {
+                gs_free_object(pgs->memory, p_cm_buff,
+                               "image_render_interpolate_icc");
+                return code;
+            }
             /* Re-set the reading stream to use the cm data */
             stream_r.ptr = p_cm_buff - 1;
             stream_r.limit = stream_r.ptr + num_bytes_decode * width_in * spp_cm;
@@ -2729,11 +2743,13 @@ image_render_interpolate_landscape_icc(gx_image_enum * penum,
                     pinterp += (pss->params.LeftMarginOut / abs_interp_limit) * spp_decode;
                     p_cm_interp = (unsigned short *) p_cm_buff;
                     p_cm_interp += (pss->params.LeftMarginOut / abs_interp_limit) * spp_cm;
-                    (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                        &input_buff_desc,
-                                                        &output_buff_desc,
-                                                        (void*) pinterp,
-                                                        (void*) p_cm_interp);
+                    code = gx_image_map_buffer(penum, dev,
+                                               &input_buff_desc,
+                                               &output_buff_desc,
+                                               (void*) pinterp,
+                                               (void*) p_cm_interp);
+                    if (code < 0)
+                        break;
                 }
                 p_cm_interp += (pss->params.LeftMarginOut / abs_interp_limit) * spp_cm;
                 for (x = xo; x < xe;) {
@@ -2814,6 +2830,8 @@ inactive:
             gs_free_object(pgs->memory, (byte *)p_cm_buff,
                            "image_render_interpolate_icc");
         }
+        if (code < 0)
+            return code;
     }
     return (h == 0 ? 0 : 1);
 }
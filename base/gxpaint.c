@@ -22,6 +22,7 @@
 #include "gxpaint.h"
 #include "gxpath.h"
 #include "gxfont.h"
+#include "gxscanc.h"
 
 static bool caching_an_outline_font(const gs_gstate * pgs)
 {
@@ -54,6 +55,22 @@ gx_fill_path(gx_path * ppath, gx_device_color * pdevc, gs_gstate * pgs,
         (dev, (const gs_gstate *)pgs, ppath, &params, pdevc, pcpath);
 }
 
+/* Fill a path in a pure color with analytic anti-aliasing. */
+int
+gx_fill_path_analytic_aa(gx_path * ppath, gx_device_color * pdevc,
+                         gs_gstate * pgs, int rule)
+{
+    gx_device *dev = gs_currentdevice_inline(pgs);
+    gx_clip_path *pcpath;
+    int code = gx_effective_clip_path(pgs, &pcpath);
+    float flatness = (caching_an_outline_font(pgs) ? 0.0 : pgs->flatness);
+
+    if (code < 0)
+        return code;
+    return gx_fill_path_analytic(dev, ppath, pcpath, float2fixed(flatness),
+                                 rule, pdevc->colors.pure);
+}
+
 /* Stroke a path for drawing or saving. */
 int
 gx_stroke_fill(gx_path * ppath, gs_gstate * pgs)
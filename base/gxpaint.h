@@ -34,6 +34,9 @@
 
 int gx_fill_path(gx_path * ppath, gx_device_color * pdevc, gs_gstate * pgs,
                  int rule, fixed adjust_x, fixed adjust_y);
+/* As gx_fill_path, anti-aliased by analytic coverage (see gxscanc.c). */
+int gx_fill_path_analytic_aa(gx_path * ppath, gx_device_color * pdevc,
+                             gs_gstate * pgs, int rule);
 int gx_stroke_fill(gx_path * ppath, gs_gstate * pgs);
 int gx_stroke_add(gx_path *ppath, gx_path *to_path, const gs_gstate * pgs, bool traditional);
 /*
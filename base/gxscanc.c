@@ -35,9 +35,15 @@
 #include "gxscanc.h"
 #include "gxfill.h"
 #include "gxdcolor.h"
+#include "gxdevmem.h"
+#include "gxsync.h"
+#include "gsstate.h"
 #include "assert_.h"
 #include <stdlib.h>             /* for qsort */
 #include <limits.h>             /* For INT_MAX */
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 /* Overview of the scan conversion algorithm.
  *
@@ -552,8 +558,17 @@ static int make_bbox(gx_path       * path,
     return ret;
 }
 
+/* The allocator for an edgebuffer's tables. Edgebuffers built on worker
+ * threads carry a thread safe one; otherwise we use the device's. */
+static inline gs_memory_t *
+edgebuffer_memory(gx_device *pdev, const gx_edgebuffer *edgebuffer)
+{
+    return edgebuffer->memory ? edgebuffer->memory : pdev->memory;
+}
+
 static inline int
 make_table_template(gx_device     * pdev,
+                    gs_memory_t   * mem,
                     gx_path       * path,
                     gs_fixed_rect * ibox,
                     int             intersection_size,
@@ -589,7 +604,7 @@ make_table_template(gx_device     * pdev,
     /* Step 1: Make us a table */
     scanlines = ibox->q.y-base_y;
     /* +1+adjust simplifies the loop below */
-    index = (int *)gs_alloc_bytes(pdev->memory,
+    index = (int *)gs_alloc_bytes(mem,
                                   (scanlines+1+adjust) * sizeof(*index),
                                   "scanc index buffer");
     if (index == NULL)
@@ -798,7 +813,7 @@ make_table_template(gx_device     * pdev,
      * the height below a suitably small number (set to be larger than
      * any max_fill_band we might meet). */
     if (scanlines > 16 && offset > 1024*1024) { /* Arbitrary */
-        gs_free_object(pdev->memory, index, "scanc index buffer");
+        gs_free_object(mem, index, "scanc index buffer");
         return offset/(1024*1024) + 1;
     }
 
@@ -806,7 +821,7 @@ make_table_template(gx_device     * pdev,
      * it's not TOO large for us to malloc. */
     if (offset != (int64_t)(uint)offset)
     {
-        gs_free_object(pdev->memory, index, "scanc index buffer");
+        gs_free_object(mem, index, "scanc index buffer");
         return_error(gs_error_VMerror);
     }
 
@@ -815,10 +830,10 @@ make_table_template(gx_device     * pdev,
      * table. */
 
     /* Step 2: Collect the real intersections */
-    table = (int *)gs_alloc_bytes(pdev->memory, offset,
+    table = (int *)gs_alloc_bytes(mem, offset,
                                   "scanc intersects buffer");
     if (table == NULL) {
-        gs_free_object(pdev->memory, index, "scanc index buffer");
+        gs_free_object(mem, index, "scanc index buffer");
         return_error(gs_error_VMerror);
     }
 
@@ -837,13 +852,14 @@ make_table_template(gx_device     * pdev,
 }
 
 static int make_table(gx_device     * pdev,
+                      gs_memory_t   * mem,
                       gx_path       * path,
                       gs_fixed_rect * ibox,
                       int           * scanlines,
                       int          ** index,
                       int          ** table)
 {
-    return make_table_template(pdev, path, ibox, 1, 1, scanlines, index, table);
+    return make_table_template(pdev, mem, path, ibox, 1, 1, scanlines, index, table);
 }
 
 static void
@@ -884,7 +900,7 @@ int gx_scan_convert(gx_device     * gs_restrict pdev,
     if (ibox.q.y <= ibox.p.y)
         return 0;
 
-    code = make_table(pdev, path, &ibox, &scanlines, &index, &table);
+    code = make_table(pdev, edgebuffer_memory(pdev, edgebuffer), path, &ibox, &scanlines, &index, &table);
     if (code != 0) /* >0 means "retry with smaller height" */
         return code;
 
@@ -2045,13 +2061,14 @@ static void mark_curve_top_app(cursor *cr, fixed sx, fixed sy, fixed c1x, fixed
 }
 
 static int make_table_app(gx_device     * pdev,
+                          gs_memory_t   * mem,
                           gx_path       * path,
                           gs_fixed_rect * ibox,
                           int           * scanlines,
                           int          ** index,
                           int          ** table)
 {
-    return make_table_template(pdev, path, ibox, 2, 0, scanlines, index, table);
+    return make_table_template(pdev, mem, path, ibox, 2, 0, scanlines, index, table);
 }
 
 static void
@@ -2095,7 +2112,7 @@ int gx_scan_convert_app(gx_device     * gs_restrict pdev,
     if (ibox.q.y <= ibox.p.y)
         return 0;
 
-    code = make_table_app(pdev, path, &ibox, &scanlines, &index, &table);
+    code = make_table_app(pdev, edgebuffer_memory(pdev, edgebuffer), path, &ibox, &scanlines, &index, &table);
     if (code != 0) /* > 0 means "retry with smaller height" */
         return code;
 
@@ -2573,13 +2590,14 @@ static void mark_curve_top_tr(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2
 }
 
 static int make_table_tr(gx_device     * pdev,
+                         gs_memory_t   * mem,
                          gx_path       * path,
                          gs_fixed_rect * ibox,
                          int           * scanlines,
                          int          ** index,
                          int          ** table)
 {
-    return make_table_template(pdev, path, ibox, 2, 1, scanlines, index, table);
+    return make_table_template(pdev, mem, path, ibox, 2, 1, scanlines, index, table);
 }
 
 static void
@@ -2623,7 +2641,7 @@ int gx_scan_convert_tr(gx_device     * gs_restrict pdev,
     if (ibox.q.y <= ibox.p.y)
         return 0;
 
-    code = make_table_tr(pdev, path, &ibox, &scanlines, &index, &table);
+    code = make_table_tr(pdev, edgebuffer_memory(pdev, edgebuffer), path, &ibox, &scanlines, &index, &table);
     if (code != 0) /* > 0 means "retry with smaller height" */
         return code;
 
@@ -4017,13 +4035,14 @@ static void mark_curve_top_tr_app(cursor_tr * gs_restrict cr, fixed sx, fixed sy
 }
 
 static int make_table_tr_app(gx_device     * pdev,
+                             gs_memory_t   * mem,
                              gx_path       * path,
                              gs_fixed_rect * ibox,
                              int           * scanlines,
                              int          ** index,
                              int          ** table)
 {
-    return make_table_template(pdev, path, ibox, 4, 0, scanlines, index, table);
+    return make_table_template(pdev, mem, path, ibox, 4, 0, scanlines, index, table);
 }
 
 static void
@@ -4072,7 +4091,7 @@ int gx_scan_convert_tr_app(gx_device     * gs_restrict pdev,
     if (ibox.q.y <= ibox.p.y)
         return 0;
 
-    code = make_table_tr_app(pdev, path, &ibox, &scanlines, &index, &table);
+    code = make_table_tr_app(pdev, edgebuffer_memory(pdev, edgebuffer), path, &ibox, &scanlines, &index, &table);
     if (code != 0) /* > 0 means "retry with smaller height" */
         return code;
 
@@ -4537,14 +4556,17 @@ gx_edgebuffer_init(gx_edgebuffer * edgebuffer)
     edgebuffer->height = 0;
     edgebuffer->index  = NULL;
     edgebuffer->table  = NULL;
+    edgebuffer->memory = NULL;
 }
 
 void
 gx_edgebuffer_fin(gx_device     * pdev,
                   gx_edgebuffer * edgebuffer)
 {
-    gs_free_object(pdev->memory, edgebuffer->table, "scanc intersects buffer");
-    gs_free_object(pdev->memory, edgebuffer->index, "scanc index buffer");
+    gs_memory_t *mem = edgebuffer_memory(pdev, edgebuffer);
+
+    gs_free_object(mem, edgebuffer->table, "scanc intersects buffer");
+    gs_free_object(mem, edgebuffer->index, "scanc index buffer");
     edgebuffer->index = NULL;
     edgebuffer->table = NULL;
 }
@@ -4577,6 +4599,323 @@ gx_scan_converter_t gx_scan_converter_tr_app =
     gx_fill_edgebuffer_tr_app
 };
 
+/* Scan convert the rows from ibox->p.y up to (at most) ymax into eb,
+ * shrinking *height (which persists from one band to the next) until
+ * the edgebuffer fits. */
+static int
+scan_convert_band(const gx_scan_converter_t *sc,
+                        gx_device           *dev,
+                        gx_path             *ppath,
+                        gs_fixed_rect       *ibox,
+                        int                  ymax,
+                        int                 *height,
+                        fixed                flat,
+                        gx_edgebuffer       *eb)
+{
+    int code;
+    int mfb = dev->max_fill_band;
+
+    while (1) {
+        ibox->q.y = ibox->p.y + *height;
+        if (ibox->q.y > ymax)
+            ibox->q.y = ymax;
+        code = sc->scan_convert(dev,
+                                ppath,
+                                ibox,
+                                eb,
+                                flat);
+        if (code <= 0)
+            break;
+        /* Let's shrink the ibox and try again */
+        if (mfb && *height == mfb) {
+            /* Can't shrink the height any more! */
+            code = gs_error_rangecheck;
+            break;
+        }
+        *height = *height/code;
+        if (mfb)
+            *height = (*height + mfb-1) & ~(mfb-1);
+        if (*height < (mfb ? mfb : 1)) {
+            code = gs_error_VMerror;
+            break;
+        }
+    }
+    return code;
+}
+
+/* Threaded scan conversion of huge paths.
+ *
+ * Where a path is too big to scan convert in one go, the serial code
+ * above works down the page in bands, shrinking the band height whenever
+ * a band's edgebuffer gets too large. Where exactly a band starts affects
+ * how lines are clipped to it (and hence the odd pixel), so to give
+ * identical results the threaded code must use exactly the same bands.
+ *
+ * The calling thread therefore acts as a scheduler. It hands the bands
+ * that the serial code would use (assuming the current height will do)
+ * out to worker threads, which scan convert and filter them. Results are
+ * collected in band order; a band that had to shrink is still good, but
+ * the ones handed out after it are thrown away and redone at the new
+ * height.
+ *
+ * Good bands are then filled in order by the calling thread. The
+ * exception is plain memory devices painted with a pure colour and no
+ * rop: bands cover disjoint rows, so there the workers fill their own.
+ */
+
+/* Paths with fewer segments than this aren't worth the threads. */
+#define SC_THREAD_MIN_SEGMENTS 20000
+
+typedef struct {
+    const gx_scan_converter_t *sc;
+    gx_device             *dev;
+    gx_path               *ppath;
+    const gs_fixed_rect   *ibox;
+    fixed                  flat;
+    int                    rule;
+    const gx_device_color *pdevc;
+    int                    lop;
+    gs_memory_t           *memory;       /* Thread safe, for the edgebuffers */
+    bool                   fill_in_thread;
+} sc_thread_common_t;
+
+typedef struct {
+    sc_thread_common_t *common;
+    gp_thread_id        thread;
+    gx_semaphore_t     *start;
+    gx_semaphore_t     *done;
+    /* Set by the scheduler before start */
+    bool                quit;
+    bool                fill;         /* Fill (if fill_in_thread) and free the last band */
+    int                 y;            /* The band to do next */
+    int                 height;
+    /* Set by the worker before done */
+    int                 final_height; /* As shrunk to fit */
+    int                 code;
+    gx_edgebuffer       eb;
+    int                 fill_code;    /* First error from filling */
+} sc_thread_t;
+
+static void
+sc_thread(void *arg)
+{
+    sc_thread_t *thread = (sc_thread_t *)arg;
+    sc_thread_common_t *c = thread->common;
+
+    for (;;) {
+        gx_semaphore_wait(thread->start);
+        if (thread->fill) {
+            int code = c->sc->fill(c->dev, c->pdevc, &thread->eb, c->lop);
+
+            if (code < 0 && thread->fill_code >= 0)
+                thread->fill_code = code;
+            thread->fill = false;
+        }
+        gx_edgebuffer_fin(c->dev, &thread->eb);
+        if (thread->quit)
+            break;
+        {
+            gs_fixed_rect ibox2 = *c->ibox;
+
+            gx_edgebuffer_init(&thread->eb);
+            thread->eb.memory = c->memory;
+            ibox2.p.y = thread->y;
+            thread->final_height = thread->height;
+            thread->code = scan_convert_band(c->sc, c->dev, c->ppath, &ibox2,
+                                             c->ibox->q.y, &thread->final_height,
+                                             c->flat, &thread->eb);
+            if (thread->code >= 0)
+                thread->code = c->sc->filter(c->dev, &thread->eb, c->rule);
+        }
+        gx_semaphore_signal(thread->done);
+    }
+}
+
+/* Bands can be filled by the worker threads only if the device fills
+ * rectangles without touching any state of its own: the chunky memory
+ * devices do. Planar ones point the device at each plane in turn, and
+ * alpha buffers flush to their target, so those are filled by the caller. */
+static bool
+sc_fill_is_thread_safe(const gx_device *dev)
+{
+    const gx_device_memory *mdproto;
+
+    if (dev->is_planar)
+        return false;
+    mdproto = gdev_mem_device_for_bits(dev->color_info.depth);
+    if (mdproto != NULL &&
+        dev_proc(dev, fill_rectangle) == dev_proc(mdproto, fill_rectangle))
+        return true;
+    mdproto = gdev_mem_word_device_for_bits(dev->color_info.depth);
+    return (mdproto != NULL &&
+            dev_proc(dev, fill_rectangle) == dev_proc(mdproto, fill_rectangle));
+}
+
+/* Returns 1 if no threads could be started, for the caller to do the
+ * fill itself. */
+static int
+scan_convert_and_fill_threaded(const gx_scan_converter_t *sc,
+                                     gx_device       *dev,
+                                     gx_path         *ppath,
+                               const gs_fixed_rect   *ibox,
+                                     fixed            flat,
+                                     int              rule,
+                               const gx_device_color *pdevc,
+                                     int              lop,
+                                     int              num_threads)
+{
+    gs_memory_t *mem = dev->memory->non_gc_memory;
+    sc_thread_common_t common;
+    sc_thread_t *threads;
+    int *queue;                 /* Busy threads, in band order */
+    int queued = 0, head = 0;
+    int mfb = dev->max_fill_band;
+    int next_y, expect_y, height;
+    int i, code = 0;
+
+    common.sc = sc;
+    common.dev = dev;
+    common.ppath = ppath;
+    common.ibox = ibox;
+    common.flat = flat;
+    common.rule = rule;
+    common.pdevc = pdevc;
+    common.lop = lop;
+    common.memory = dev->memory->thread_safe_memory;
+    /* A pure colour with no source rop goes straight to fill_rectangle
+     * (see gx_dc_pure_fill_rectangle). */
+    common.fill_in_thread = (gx_dc_is_pure(pdevc) &&
+                             (lop < 0 || lop_no_S_is_T(lop)) &&
+                             sc_fill_is_thread_safe(dev));
+
+    threads = (sc_thread_t *)gs_alloc_byte_array(mem, num_threads, sizeof(sc_thread_t),
+                                                 "scan_convert_and_fill_threaded");
+    queue = (int *)gs_alloc_byte_array(mem, num_threads, sizeof(int),
+                                       "scan_convert_and_fill_threaded");
+    if (threads == NULL || queue == NULL) {
+        gs_free_object(mem, threads, "scan_convert_and_fill_threaded");
+        gs_free_object(mem, queue, "scan_convert_and_fill_threaded");
+        return 1;
+    }
+    memset(threads, 0, num_threads * sizeof(sc_thread_t));
+    for (i = 0; i < num_threads; i++) {
+        sc_thread_t *thread = &threads[i];
+
+        thread->common = &common;
+        gx_edgebuffer_init(&thread->eb);
+        thread->start = gx_semaphore_label(gx_semaphore_alloc(mem), "scanc start");
+        thread->done = gx_semaphore_label(gx_semaphore_alloc(mem), "scanc done");
+        if (thread->start == NULL || thread->done == NULL ||
+            gp_thread_start(sc_thread, thread, &thread->thread) < 0) {
+            /* Make do with the threads we have (we may be on a platform
+             * without threads). */
+            gx_semaphore_free(thread->start);
+            gx_semaphore_free(thread->done);
+            break;
+        }
+        gp_thread_label(thread->thread, "Scan converter");
+    }
+    num_threads = i;
+    if (num_threads == 0) {
+        gs_free_object(mem, threads, "scan_convert_and_fill_threaded");
+        gs_free_object(mem, queue, "scan_convert_and_fill_threaded");
+        return 1;
+    }
+
+    /* The first band is the whole thing, as for the serial code. Until
+     * that comes back (shrunk), there's nothing else to hand out. */
+    expect_y = next_y = (mfb != 0 ? ibox->p.y & ~(mfb-1) : ibox->p.y);
+    height = ibox->q.y - next_y;
+    if (mfb != 0)
+        height = (height + mfb-1) & ~(mfb-1);
+    for (;;) {
+        sc_thread_t *thread;
+        int t;
+
+        /* Keep every idle thread busy with the bands that follow on. */
+        for (i = 0; i < num_threads && queued < num_threads && code >= 0 &&
+                    next_y < ibox->q.y; i++) {
+            int j;
+
+            for (j = 0; j < queued; j++)
+                if (queue[(head + j) % num_threads] == i)
+                    break;
+            if (j < queued)
+                continue;
+            threads[i].y = next_y;
+            threads[i].height = height;
+            next_y += height;
+            queue[(head + queued++) % num_threads] = i;
+            gx_semaphore_signal(threads[i].start);
+        }
+        if (queued == 0)
+            break;
+
+        /* Collect the oldest. */
+        t = queue[head];
+        head = (head + 1) % num_threads;
+        queued--;
+        thread = &threads[t];
+        gx_semaphore_wait(thread->done);
+        if (thread->y != expect_y || thread->height != height || code < 0) {
+            /* Handed out before an earlier band shrank; the serial code
+             * would never have made this one. */
+            continue;
+        }
+        if (thread->code < 0) {
+            code = thread->code;
+            continue;
+        }
+        if (common.fill_in_thread)
+            thread->fill = true;
+        else {
+            code = sc->fill(dev, pdevc, &thread->eb, lop);
+            gx_edgebuffer_fin(dev, &thread->eb);
+        }
+        expect_y += thread->final_height;
+        if (thread->final_height != height) {
+            /* Everything after this band is at the wrong height. */
+            height = thread->final_height;
+            next_y = expect_y;
+        }
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        sc_thread_t *thread = &threads[i];
+
+        thread->quit = true;
+        gx_semaphore_signal(thread->start);
+        gp_thread_finish(thread->thread);
+        gx_semaphore_free(thread->start);
+        gx_semaphore_free(thread->done);
+        if (code >= 0 && thread->fill_code < 0)
+            code = thread->fill_code;
+    }
+    gs_free_object(mem, threads, "scan_convert_and_fill_threaded");
+    gs_free_object(mem, queue, "scan_convert_and_fill_threaded");
+
+    return code;
+}
+
+/* How many threads (if any) to scan convert ppath with. */
+static int
+scan_convert_threads(gx_device *dev, gx_path *ppath, const gs_fixed_rect *ibox)
+{
+    int num_threads = gs_getscanconverterthreads(dev->memory);
+    const segment *pseg;
+    int segments;
+
+    if (num_threads < 1 || dev->memory->thread_safe_memory == NULL)
+        return 0;
+    /* Curves flatten to several lines apiece; count them as 8. */
+    segments = 7 * ppath->curve_count;
+    for (pseg = (const segment *)ppath->first_subpath;
+         pseg != NULL && segments < SC_THREAD_MIN_SEGMENTS;
+         pseg = pseg->next)
+        segments++;
+    return segments < SC_THREAD_MIN_SEGMENTS ? 0 : num_threads;
+}
+
 int
 gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
                                gx_device       *dev,
@@ -4592,6 +4931,14 @@ gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
     gs_fixed_rect ibox2 = *ibox;
     int height;
     int mfb = dev->max_fill_band;
+    int num_threads = scan_convert_threads(dev, ppath, ibox);
+
+    if (num_threads > 0) {
+        code = scan_convert_and_fill_threaded(sc, dev, ppath, ibox, flat,
+                                              rule, pdevc, lop, num_threads);
+        if (code != 1)
+            return code;
+    }
 
     if (mfb != 0) {
         ibox2.p.y &= ~(mfb-1);
@@ -4601,31 +4948,7 @@ gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
 
     do {
         gx_edgebuffer_init(&eb);
-        while (1) {
-            ibox2.q.y = ibox2.p.y + height;
-            if (ibox2.q.y > ibox->q.y)
-                ibox2.q.y = ibox->q.y;
-            code = sc->scan_convert(dev,
-                                    ppath,
-                                    &ibox2,
-                                    &eb,
-                                    flat);
-            if (code <= 0)
-                break;
-            /* Let's shrink the ibox and try again */
-            if (mfb && height == mfb) {
-                /* Can't shrink the height any more! */
-                code = gs_error_rangecheck;
-                break;
-            }
-            height = height/code;
-            if (mfb)
-                height = (height + mfb-1) & ~(mfb-1);
-            if (height < (mfb ? mfb : 1)) {
-                code = gs_error_VMerror;
-                break;
-            }
-        }
+        code = scan_convert_band(sc, dev, ppath, &ibox2, ibox->q.y, &height, flat, &eb);
         if (code >= 0)
             code = sc->filter(dev,
                               &eb,
@@ -4642,3 +4965,402 @@ gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
 
     return code;
 }
+
+/* Analytic coverage anti-aliasing.
+ *
+ * Rather than rendering the path supersampled into the alpha buffer device
+ * and reducing it, we work out exactly how much of each pixel lies inside
+ * it. Every edge deposits, into a per scanline accumulation buffer, the
+ * signed area it contributes to the pixel(s) it crosses and the remainder
+ * of its height into the pixel to the right of those. A running sum along
+ * the scanline then gives the winding coverage of every pixel, which is
+ * sent to the device as 8 bit alpha (or as rectangles, where solid).
+ *
+ * The buffer is sparse in the sense that only the cells that edges touch
+ * are written; the summing pass clears it again as it reads.
+ */
+
+/* The largest accumulation buffer (in floats) we use; taller paths are
+ * done in bands of rows, walking the path once per band. */
+#define AA_BAND_FLOATS 65536
+
+/* Runs of at least this many fully covered pixels are filled as
+ * rectangles rather than sent as alpha. */
+#define AA_SOLID_RUN 8
+
+typedef struct {
+    float *acc;
+    int    width;   /* In pixels */
+    int    stride;  /* In floats; width + 2 */
+    int    rows;
+} aa_band;
+
+/* Accumulate a line lying within 0 <= x <= width. y is only clipped
+ * here. */
+static void
+aa_accumulate(const aa_band * gs_restrict b, float x0, float y0, float x1, float y1)
+{
+    float w = (float)b->width;
+    float dir, dxdy, x, d;
+    int y, ystart, yend;
+
+    if (y0 < y1)
+        dir = 1.0f;
+    else {
+        float t;
+
+        dir = -1.0f;
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    dxdy = (x1 - x0) / (y1 - y0);
+    ystart = (int)floor(y0);
+    if (ystart < 0)
+        ystart = 0;
+    yend = (int)ceil(y1);
+    if (yend > b->rows)
+        yend = b->rows;
+    x = (ystart > y0 ? x0 + dxdy * (ystart - y0) : x0);
+    if (x < 0)
+        x = 0;
+    else if (x > w)
+        x = w;
+
+    for (y = ystart; y < yend; y++) {
+        float *row = b->acc + y * b->stride;
+        float ytop = (y > y0 ? (float)y : y0);
+        float ybot = (y + 1 < y1 ? (float)(y + 1) : y1);
+        float dy = ybot - ytop;
+        float xnext = x + dxdy * dy;
+        float xa, xb, xafloor, xbceil;
+        int xai, xbi;
+
+        if (xnext < 0)
+            xnext = 0;
+        else if (xnext > w)
+            xnext = w;
+        d = dy * dir;
+        if (x < xnext)
+            xa = x, xb = xnext;
+        else
+            xa = xnext, xb = x;
+        xafloor = (float)floor(xa);
+        xai = (int)xafloor;
+        xbceil = (float)ceil(xb);
+        xbi = (int)xbceil;
+        if (xbi <= xai + 1) {
+            /* Within a single pixel. */
+            float xmf = 0.5f * (x + xnext) - xafloor;
+
+            row[xai] += d - d * xmf;
+            row[xai + 1] += d * xmf;
+        } else {
+            float s = 1.0f / (xb - xa);
+            float xaf = xa - xafloor;
+            float a0 = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+            float xbf = xb - xbceil + 1.0f;
+            float am = 0.5f * s * xbf * xbf;
+
+            row[xai] += d * a0;
+            if (xbi == xai + 2)
+                row[xai + 1] += d * (1.0f - a0 - am);
+            else {
+                float a1 = s * (1.5f - xaf);
+                float a2 = a1 + (xbi - xai - 3) * s;
+                int xi;
+
+                row[xai + 1] += d * (a1 - a0);
+                for (xi = xai + 2; xi < xbi - 1; xi++)
+                    row[xi] += d * s;
+                row[xbi - 1] += d * (1.0f - a2 - am);
+            }
+            row[xbi] += d * am;
+        }
+        x = xnext;
+    }
+}
+
+/* Accumulate a line, clipping it to the band. Anything to the left of the
+ * band still covers it, so is folded onto its left edge; anything to the
+ * right can be dropped. */
+static void
+aa_line(const aa_band * gs_restrict b, float x0, float y0, float x1, float y1)
+{
+    float w = (float)b->width;
+    float yc;
+
+    if (y0 == y1 || (y0 <= 0 && y1 <= 0) || (y0 >= b->rows && y1 >= b->rows))
+        return;
+    if ((x0 < 0) != (x1 < 0)) {
+        yc = y0 - x0 * (y1 - y0) / (x1 - x0);
+        if (x0 < 0) {
+            aa_line(b, 0, y0, 0, yc);
+            aa_line(b, 0, yc, x1, y1);
+        } else {
+            aa_line(b, x0, y0, 0, yc);
+            aa_line(b, 0, yc, 0, y1);
+        }
+        return;
+    }
+    if (x0 < 0)
+        x0 = x1 = 0;
+    if ((x0 > w) != (x1 > w)) {
+        yc = y0 + (w - x0) * (y1 - y0) / (x1 - x0);
+        if (x0 > w)
+            aa_line(b, w, yc, x1, y1);
+        else
+            aa_line(b, x0, y0, w, yc);
+        return;
+    }
+    if (x0 > w)
+        return;
+    aa_accumulate(b, x0, y0, x1, y1);
+}
+
+static void
+aa_curve(const aa_band * gs_restrict b, float sx, float sy, float c1x, float c1y,
+         float c2x, float c2y, float ex, float ey, int depth)
+{
+    float ax, ay, bx, by, cx, cy, dx, dy, fx, fy, gx, gy;
+
+    /* The curve lies within the hull of its control points, so we can
+     * skip it without subdividing if they all miss the band. */
+    if ((sy <= 0 && c1y <= 0 && c2y <= 0 && ey <= 0) ||
+        (sy >= b->rows && c1y >= b->rows && c2y >= b->rows && ey >= b->rows))
+        return;
+    if (depth <= 0) {
+        aa_line(b, sx, sy, ex, ey);
+        return;
+    }
+    ax = (sx + c1x) * 0.5f;
+    ay = (sy + c1y) * 0.5f;
+    bx = (c1x + c2x) * 0.5f;
+    by = (c1y + c2y) * 0.5f;
+    cx = (c2x + ex) * 0.5f;
+    cy = (c2y + ey) * 0.5f;
+    dx = (ax + bx) * 0.5f;
+    dy = (ay + by) * 0.5f;
+    fx = (bx + cx) * 0.5f;
+    fy = (by + cy) * 0.5f;
+    gx = (dx + fx) * 0.5f;
+    gy = (dy + fy) * 0.5f;
+    depth--;
+    aa_curve(b, sx, sy, ax, ay, dx, dy, gx, gy, depth);
+    aa_curve(b, gx, gy, fx, fy, cx, cy, ex, ey, depth);
+}
+
+/* Accumulate the whole path into the band whose top left pixel is at
+ * (xorg, yorg). */
+static void
+aa_walk_path(const aa_band * gs_restrict b, const gx_path * ppath,
+             int xorg, int yorg, fixed flat)
+{
+    const subpath *psub;
+
+#define AA_X(v) ((float)((double)(v) / fixed_scale - xorg))
+#define AA_Y(v) ((float)((double)(v) / fixed_scale - yorg))
+    for (psub = ppath->first_subpath; psub != 0;) {
+        const segment *pseg = (const segment *)psub;
+        fixed ex = pseg->pt.x;
+        fixed ey = pseg->pt.y;
+        fixed ix = ex;
+        fixed iy = ey;
+
+        while ((pseg = pseg->next) != 0 &&
+               pseg->type != s_start
+            ) {
+            fixed sx = ex;
+            fixed sy = ey;
+
+            ex = pseg->pt.x;
+            ey = pseg->pt.y;
+            if (pseg->type == s_curve) {
+                const curve_segment *const pcur = (const curve_segment *)pseg;
+                int k = gx_curve_log2_samples(sx, sy, pcur, flat);
+
+                aa_curve(b, AA_X(sx), AA_Y(sy), AA_X(pcur->p1.x), AA_Y(pcur->p1.y),
+                         AA_X(pcur->p2.x), AA_Y(pcur->p2.y), AA_X(ex), AA_Y(ey), k);
+            } else if (sy != ey)
+                aa_line(b, AA_X(sx), AA_Y(sy), AA_X(ex), AA_Y(ey));
+        }
+        /* And close any open segments */
+        if (iy != ey)
+            aa_line(b, AA_X(ex), AA_Y(ey), AA_X(ix), AA_Y(iy));
+        psub = (const subpath *)pseg;
+    }
+#undef AA_X
+#undef AA_Y
+}
+
+/* Sum an accumulation row into 8 bit coverage, clearing it as we go. */
+static void
+aa_coverage_row(float * gs_restrict acc, byte * gs_restrict cov, int width, int rule)
+{
+    float c = 0;
+    int i = 0;
+
+#ifdef HAVE_SSE2
+    /* Non-zero winding, 4 pixels at a time: an in-register prefix sum
+     * plus the carry from the previous 4. */
+    if (rule != gx_rule_even_odd) {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 carry = zero;
+
+        for (; i + 4 <= width; i += 4) {
+            __m128 x = _mm_loadu_ps(acc + i);
+            __m128i v;
+            int packed;
+
+            _mm_storeu_ps(acc + i, zero);
+            x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+            x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+            x = _mm_add_ps(x, carry);
+            carry = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+            x = _mm_min_ps(_mm_andnot_ps(sign, x), one);
+            v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, scale), half));
+            v = _mm_packs_epi32(v, v);
+            v = _mm_packus_epi16(v, v);
+            packed = _mm_cvtsi128_si32(v);
+            memcpy(cov + i, &packed, 4);
+        }
+        c = _mm_cvtss_f32(carry);
+    }
+#endif
+    for (; i < width; i++) {
+        float a;
+
+        c += acc[i];
+        acc[i] = 0;
+        a = (c < 0 ? -c : c);
+        if (rule == gx_rule_even_odd) {
+            a -= 2.0f * (float)floor(a * 0.5f);
+            if (a > 1.0f)
+                a = 2.0f - a;
+        } else if (a > 1.0f)
+            a = 1.0f;
+        cov[i] = (byte)(a * 255.0f + 0.5f);
+    }
+    acc[width] = acc[width + 1] = 0;
+}
+
+/* Send one row of coverage to the device: solid runs as rectangles, the
+ * rest as alpha. */
+static int
+aa_emit_row(gx_device *dev, const byte *cov, int width, int x0, int y,
+            gx_color_index color)
+{
+    int x = 0;
+    int code;
+
+    while (x < width) {
+        int start, solid;
+
+        while (x < width && cov[x] == 0)
+            x++;
+        if (x == width)
+            break;
+        start = x;
+        while (x < width && cov[x] != 0) {
+            if (cov[x] != 255) {
+                x++;
+                continue;
+            }
+            solid = x;
+            while (x < width && cov[x] == 255)
+                x++;
+            if (x - solid < AA_SOLID_RUN)
+                continue;
+            if (solid > start) {
+                code = dev_proc(dev, copy_alpha)(dev, cov, start, width, gx_no_bitmap_id,
+                                                 x0 + start, y, solid - start, 1, color, 8);
+                if (code < 0)
+                    return code;
+            }
+            code = dev_proc(dev, fill_rectangle)(dev, x0 + solid, y, x - solid, 1, color);
+            if (code < 0)
+                return code;
+            start = x;
+        }
+        if (x > start) {
+            code = dev_proc(dev, copy_alpha)(dev, cov, start, width, gx_no_bitmap_id,
+                                             x0 + start, y, x - start, 1, color, 8);
+            if (code < 0)
+                return code;
+        }
+    }
+    return 0;
+}
+
+int
+gx_fill_path_analytic(gx_device          *dev,
+                      gx_path            *ppath,
+                const gx_clip_path       *pcpath,
+                      fixed               flat,
+                      int                 rule,
+                      gx_color_index      color)
+{
+    gs_memory_t *mem = dev->memory;
+    gx_device_clip cdev;
+    gs_fixed_rect bbox, cbox;
+    int x0, y0, y1, y, i;
+    int band_rows;
+    aa_band b;
+    byte *cov;
+    int code;
+
+    /* Bale out if no actual path. */
+    if (ppath->first_subpath == NULL)
+        return 0;
+    code = gx_path_bbox(ppath, &bbox);
+    if (code < 0)
+        return code;
+    (*dev_proc(dev, get_clipping_box))(dev, &cbox);
+    rect_intersect(bbox, cbox);
+    if (bbox.p.x >= bbox.q.x || bbox.p.y >= bbox.q.y)
+        return 0;
+    if (pcpath) {
+        dev = gx_make_clip_device_on_stack_if_needed(&cdev, pcpath, dev, &bbox);
+        if (dev == NULL)
+            return 0;
+    }
+
+    x0 = fixed2int(bbox.p.x);
+    y0 = fixed2int(bbox.p.y);
+    y1 = fixed2int_ceiling(bbox.q.y);
+    b.width = fixed2int_ceiling(bbox.q.x) - x0;
+    b.stride = b.width + 2;
+    band_rows = AA_BAND_FLOATS / b.stride;
+    if (band_rows < 1)
+        band_rows = 1;
+    if (band_rows > y1 - y0)
+        band_rows = y1 - y0;
+    b.acc = (float *)gs_alloc_byte_array(mem, (size_t)b.stride * band_rows, sizeof(float),
+                                         "gx_fill_path_analytic(acc)");
+    cov = gs_alloc_bytes(mem, b.width, "gx_fill_path_analytic(cov)");
+    if (b.acc == NULL || cov == NULL) {
+        code = gs_note_error(gs_error_VMerror);
+        goto out;
+    }
+    memset(b.acc, 0, (size_t)b.stride * band_rows * sizeof(float));
+
+    for (y = y0; y < y1 && code >= 0; y += band_rows) {
+        b.rows = min(band_rows, y1 - y);
+        aa_walk_path(&b, ppath, x0, y, flat);
+        for (i = 0; i < b.rows; i++) {
+            aa_coverage_row(b.acc + i * b.stride, cov, b.width, rule);
+            if (code >= 0)
+                code = aa_emit_row(dev, cov, b.width, x0, y + i, color);
+        }
+    }
+
+out:
+    gs_free_object(mem, cov, "gx_fill_path_analytic(cov)");
+    gs_free_object(mem, b.acc, "gx_fill_path_analytic(acc)");
+    if (dev == (gx_device *)&cdev)
+        gx_destroy_clip_device_on_stack(&cdev);
+    return code;
+}
@@ -39,6 +39,7 @@ struct gx_edgebuffer_s {
     int  xmax;
     int *index;
     int *table;
+    gs_memory_t *memory; /* Allocator for index/table, or NULL to use the device's */
 };
 
 typedef struct {
@@ -153,5 +154,15 @@ void gx_edgebuffer_init(gx_edgebuffer * edgebuffer);
 void gx_edgebuffer_fin(gx_device     * pdev,
                        gx_edgebuffer * edgebuffer);
 
+/* Analytic coverage (anti-aliased) fill of a path in a pure color, sent
+ * to dev as 8 bit alpha spans through copy_alpha. */
+int
+gx_fill_path_analytic(gx_device          *dev,
+                      gx_path            *ppath,
+                const gx_clip_path       *pcpath,
+                      fixed               flat,
+                      int                 rule,
+                      gx_color_index      color);
+
 
 #endif /* gxscanc_INCLUDED */
@@ -1402,6 +1402,36 @@ patch_color_to_device_color(const patch_fill_state_t *pfs, const patch_color_t *
     return patch_color_to_device_color_inline(pfs, c, pdevc, NULL);
 }
 
+/* Convert several patch colors at once, so that the color index cache
+   can hash them together. Stops at the first non-zero code, which has
+   the same meaning as for patch_color_to_device_color_inline. */
+static int
+patch_colors_to_device_colors(const patch_fill_state_t *pfs, int count,
+                              const patch_color_t **c, gx_device_color *pdevc,
+                              frac31 fc[][GX_DEVICE_COLOR_MAX_COMPONENTS])
+{
+    int i, code;
+
+    if (pfs->pcic != NULL && !DEBUG_COLOR_INDEX_CACHE) {
+        float paint_values[3 * GS_CLIENT_COLOR_MAX_COMPONENTS];
+        int n = pfs->num_components;
+
+        if (count > 3)
+            return_error(gs_error_rangecheck);
+        for (i = 0; i < count; i++)
+            memcpy(paint_values + i * n, c[i]->cc.paint.values, sizeof(float) * n);
+        return gs_cached_color_indices(pfs->pcic, paint_values, count, pdevc,
+                                       fc[0], GX_DEVICE_COLOR_MAX_COMPONENTS);
+    }
+    for (i = 0; i < count; i++) {
+        code = patch_color_to_device_color_inline(pfs, c[i],
+                        (pdevc == NULL ? NULL : &pdevc[i]), fc[i]);
+        if (code != 0)
+            return code;
+    }
+    return 0;
+}
+
 static inline double
 color_span(const patch_fill_state_t *pfs, const patch_color_t *c0, const patch_color_t *c1)
 {
@@ -1625,7 +1655,13 @@ decompose_linear_color(patch_fill_state_t *pfs, gs_fixed_edge *le, gs_fixed_edge
             fa.lop = 0;
             fa.ystart = ybot;
             fa.yend = ytop;
-            code = patch_color_to_device_color_inline(pfs, c0, NULL, fc[0]);
+            {
+                const patch_color_t *cc[2];
+
+                cc[0] = c0;
+                cc[1] = c1;
+                code = patch_colors_to_device_colors(pfs, 2, cc, NULL, fc);
+            }
             if (code < 0)
                 goto out;
             if (code == 2) {
@@ -1633,9 +1669,6 @@ decompose_linear_color(patch_fill_state_t *pfs, gs_fixed_edge *le, gs_fixed_edge
                 code=gs_note_error(gs_error_unregistered);
                 goto out;
             }
-            code = patch_color_to_device_color_inline(pfs, c1, NULL, fc[1]);
-            if (code < 0)
-                goto out;
             code = dev_proc(pdev, fill_linear_color_trapezoid)(pdev, &fa,
                             &le->start, &le->end, &re->start, &re->end,
                             fc[0], fc[1], NULL, NULL);
@@ -2082,28 +2115,27 @@ try_device_linear_color(patch_fill_state_t *pfs, bool wedge,
         frac31 fc[3][GX_DEVICE_COLOR_MAX_COMPONENTS];
         gs_fill_attributes fa;
         gx_device_color dc[3];
+        const patch_color_t *c[3];
+        int n = 0;
 
         fa.clip = &pfs->rect;
         fa.ht = NULL;
         fa.swap_axes = false;
         fa.lop = 0;
-        code = patch_color_to_device_color_inline(pfs, p0->c, &dc[0], fc[0]);
+        /* A wedge has no middle color, so pack the ends together. */
+        c[n++] = p0->c;
+        if (!wedge)
+            c[n++] = p1->c;
+        c[n++] = p2->c;
+        code = patch_colors_to_device_colors(pfs, n, c, dc, fc);
         if (code != 0)
             return code;
         if (!(dc[0].type == &gx_dc_type_data_pure ||
             dc[0].type == &gx_dc_type_data_devn))
             return 2;
-        if (!wedge) {
-            code = patch_color_to_device_color_inline(pfs, p1->c, &dc[1], fc[1]);
-            if (code != 0)
-                return code;
-        }
-        code = patch_color_to_device_color_inline(pfs, p2->c, &dc[2], fc[2]);
-        if (code != 0)
-            return code;
         code = dev_proc(pdev, fill_linear_color_triangle)(pdev, &fa,
                         &p0->p, &p1->p, &p2->p,
-                        fc[0], (wedge ? NULL : fc[1]), fc[2]);
+                        fc[0], (wedge ? NULL : fc[1]), fc[n - 1]);
         if (code == 1)
             return 0; /* The area is filled. */
         if (code < 0)
@@ -16,6 +16,7 @@
 
 /* Path stroking procedures for Ghostscript library */
 #include "math_.h"
+#include "memory_.h"
 #include <stdlib.h> /* abs() */
 #include "gx.h"
 #include "gpcheck.h"
@@ -35,6 +36,9 @@
 #include "gzcpath.h"
 #include "gxpaint.h"
 #include "gsstate.h"            /* for gs_currentcpsimode */
+#include "gxsync.h"             /* for the stroke cache monitor */
+#include "gslibctx.h"
+#include "gzspotan.h"           /* for san_open */
 
 /* RJW: There appears to be a difference in the xps and postscript models
  * (at least in as far as Microsofts implementation of xps and Acrobats of
@@ -1061,12 +1065,462 @@ gx_stroke_path_only_aux(gx_path * ppath, gx_path * to_path, gx_device * pdev,
     return code;
 }
 
+/*
+ * strokepath, and the anti-aliased stroke that fills the whole outline as
+ * one unit, build the complete stroke outline in to_path.  Documents tend
+ * to stroke the same small shapes over and over (markers, symbols, hatching,
+ * repeated form content), so keep the outlines of recent strokes in the
+ * library core.  The key is the path, relative to a whole pixel origin,
+ * together with everything in the graphics state that the stroker consults.
+ * The stroker (and the flattener and dasher it calls) only work on
+ * differences of device coordinates, and stroke adjustment rounds to whole
+ * pixels, so an outline can be replayed wherever the same path reappears at
+ * a whole pixel offset.  Stroke adjustment also consults and updates the
+ * stroked gradient recognizer of the device (dev->sgr), so that is part of
+ * the key, and its final state is replayed along with the outline.  As with
+ * the spot order cache in gsht.c, the cache is shared by all the contexts
+ * using the core, lives as long as the core, and is protected by the core
+ * monitor.
+ */
+#define STROKE_CACHE_SIZE 32
+#define STROKE_CACHE_MAX_KEY 1024       /* in fixeds, about 300 segments */
+#define STROKE_CACHE_MAX_OUTLINE 16384  /* in fixeds */
+#define STROKE_CACHE_MAX_DASHES 32
+/* Keep all coordinates far enough from the limits that no difference */
+/* computed by the stroker can overflow. */
+#define STROKE_CACHE_COORD_OK(v)\
+  ((v) > -(max_fixed >> 2) && (v) < (max_fixed >> 2))
+
+typedef struct stroke_cache_entry_s {
+    uint hash;                  /* 0 = unused */
+    int key_size;
+    int outline_size;
+    int sgr_mode;               /* see stroke_cache_set_sgr */
+    gx_stroked_gradient_recognizer_t sgr;       /* relative to the origin */
+    ulong last_used;
+    fixed *key;                 /* key_size, followed by the outline */
+    fixed *outline;
+} stroke_cache_entry_t;
+
+typedef struct stroke_cache_s {
+    ulong clock;
+    stroke_cache_entry_t entries[STROKE_CACHE_SIZE];
+} stroke_cache_t;
+
+static void
+stroke_cache_free(gs_memory_t *mem, void *data)
+{
+    stroke_cache_t *cache = (stroke_cache_t *)data;
+    int i;
+
+    for (i = 0; i < STROKE_CACHE_SIZE; i++)
+        gs_free_object(mem, cache->entries[i].key, "stroke_cache_free(entry)");
+    gs_free_object(mem, cache, "stroke_cache_free");
+}
+
+/*
+ * Append the segments of a path to buf (if not NULL), relative to origin.
+ * Return the new size, or -1 if the path doesn't fit in max_size or has
+ * segments we don't record.
+ */
+static int
+stroke_cache_put_path(const gx_path *ppath, const gs_fixed_point *origin,
+                      fixed *buf, int size, int max_size)
+{
+    const segment *pseg;
+
+    for (pseg = (const segment *)ppath->first_subpath; pseg != 0;
+         pseg = pseg->next) {
+        int info = pseg->type + (pseg->notes << 8);
+        int n = 3;
+
+        switch (pseg->type) {
+            case s_start:
+                if (((const subpath *)pseg)->is_closed)
+                    info += 1 << 24;
+                break;
+            case s_curve: {
+                const curve_segment *pc = (const curve_segment *)pseg;
+
+                if (!STROKE_CACHE_COORD_OK(pc->p1.x) ||
+                    !STROKE_CACHE_COORD_OK(pc->p1.y) ||
+                    !STROKE_CACHE_COORD_OK(pc->p2.x) ||
+                    !STROKE_CACHE_COORD_OK(pc->p2.y))
+                    return -1;
+                n = 7;
+                break;
+            }
+            case s_line:
+            case s_line_close:
+            case s_gap:
+                break;
+            default:
+                return -1;
+        }
+        if (size + n > max_size ||
+            !STROKE_CACHE_COORD_OK(pseg->pt.x) ||
+            !STROKE_CACHE_COORD_OK(pseg->pt.y))
+            return -1;
+        if (buf != NULL) {
+            buf[size] = info;
+            if (pseg->type == s_curve) {
+                const curve_segment *pc = (const curve_segment *)pseg;
+
+                buf[size + 1] = pc->p1.x - origin->x;
+                buf[size + 2] = pc->p1.y - origin->y;
+                buf[size + 3] = pc->p2.x - origin->x;
+                buf[size + 4] = pc->p2.y - origin->y;
+            }
+            buf[size + n - 2] = pseg->pt.x - origin->x;
+            buf[size + n - 1] = pseg->pt.y - origin->y;
+        }
+        size += n;
+    }
+    return size;
+}
+
+/* Translate the points (but not the vectors) of a gradient recognizer. */
+static void
+stroke_cache_translate_sgr(gx_stroked_gradient_recognizer_t *sgr,
+                           fixed dx, fixed dy)
+{
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        sgr->orig[i].x += dx;
+        sgr->orig[i].y += dy;
+        sgr->adjusted[i].x += dx;
+        sgr->adjusted[i].y += dy;
+    }
+}
+
+/*
+ * Update dev->sgr the way stroking did: mode 0 leaves it alone, mode 1
+ * clears stroke_stored, mode 2 sets it to the (relative) state recorded.
+ */
+static void
+stroke_cache_set_sgr(gx_device *pdev, int mode,
+                     const gx_stroked_gradient_recognizer_t *sgr,
+                     const gs_fixed_point *origin)
+{
+    if (mode == 1)
+        pdev->sgr.stroke_stored = false;
+    else if (mode == 2) {
+        pdev->sgr = *sgr;
+        stroke_cache_translate_sgr(&pdev->sgr, origin->x, origin->y);
+    }
+}
+
+static fixed
+stroke_cache_float(float v)
+{
+    union { float f; int i; } u;
+
+    u.f = v;
+    return (fixed)u.i;
+}
+
+/*
+ * Build the key for stroking ppath into an outline.  Return its size,
+ * or -1 if the stroke shouldn't be cached.
+ */
+static int
+stroke_cache_key(const gx_path *ppath, gx_device *pdev,
+                 const gs_gstate *pgs, const gx_stroke_params *params,
+                 const gs_fixed_point *origin, fixed *key)
+{
+    const gx_line_params *pgs_lp = gs_currentlineparams_inline(pgs);
+    const gx_dash_params *dash = &pgs_lp->dash;
+    gs_matrix imat;
+    int size = 0;
+    uint i;
+
+    if (dash->pattern_size > STROKE_CACHE_MAX_DASHES)
+        return -1;
+    (*dev_proc(pdev, get_initial_matrix)) (pdev, &imat);
+#define PUT_INT(v) (key[size++] = (fixed)(v))
+#define PUT_FLOAT(v) (key[size++] = stroke_cache_float(v))
+    PUT_INT(gs_currentcpsimode(pgs->memory) +
+            (params->traditional << 1) +
+            (pgs_lp->dot_length_absolute << 2) +
+            (dash->adapt << 3) + (dash->init_ink_on << 4) +
+            (pgs->stroke_adjust << 5));
+    PUT_INT(pgs_lp->start_cap);
+    PUT_INT(pgs_lp->end_cap);
+    PUT_INT(pgs_lp->dash_cap);
+    PUT_INT(pgs_lp->join);
+    PUT_INT(pgs_lp->curve_join);
+    PUT_FLOAT(pgs_lp->half_width);
+    PUT_FLOAT(pgs_lp->miter_limit);
+    PUT_FLOAT(pgs_lp->miter_check);
+    PUT_FLOAT(pgs_lp->dot_length);
+    PUT_FLOAT(pgs_lp->dot_orientation.xx);
+    PUT_FLOAT(pgs_lp->dot_orientation.xy);
+    PUT_FLOAT(pgs_lp->dot_orientation.yx);
+    PUT_FLOAT(pgs_lp->dot_orientation.yy);
+    PUT_FLOAT(pgs->ctm.xx);
+    PUT_FLOAT(pgs->ctm.xy);
+    PUT_FLOAT(pgs->ctm.yx);
+    PUT_FLOAT(pgs->ctm.yy);
+    PUT_FLOAT(imat.xx);
+    PUT_FLOAT(imat.xy);
+    PUT_FLOAT(imat.yx);
+    PUT_FLOAT(imat.yy);
+    PUT_FLOAT(params->flatness);
+    PUT_INT(pgs->fill_adjust.x);
+    PUT_INT(pgs->fill_adjust.y);
+    PUT_INT(dash->pattern_size);
+    PUT_INT(dash->init_index);
+    PUT_FLOAT(dash->offset);
+    PUT_FLOAT(dash->pattern_length);
+    PUT_FLOAT(dash->init_dist_left);
+    for (i = 0; i < dash->pattern_size; i++)
+        PUT_FLOAT(dash->pattern[i]);
+    /* Stroke adjustment may look at the previous stroke. */
+    if (pgs->stroke_adjust && pdev->sgr.stroke_stored) {
+        for (i = 0; i < 4; i++) {
+            gs_fixed_point orig = pdev->sgr.orig[i];
+            gs_fixed_point adjusted = pdev->sgr.adjusted[i];
+
+            if (!STROKE_CACHE_COORD_OK(orig.x) ||
+                !STROKE_CACHE_COORD_OK(orig.y) ||
+                !STROKE_CACHE_COORD_OK(adjusted.x) ||
+                !STROKE_CACHE_COORD_OK(adjusted.y))
+                return -1;
+            if (i < 2) {
+                orig.x -= origin->x, orig.y -= origin->y;
+                adjusted.x -= origin->x, adjusted.y -= origin->y;
+            }
+            PUT_INT(orig.x);
+            PUT_INT(orig.y);
+            PUT_INT(adjusted.x);
+            PUT_INT(adjusted.y);
+        }
+    } else
+        PUT_INT(-1);
+#undef PUT_INT
+#undef PUT_FLOAT
+    return stroke_cache_put_path(ppath, origin, key, size,
+                                 STROKE_CACHE_MAX_KEY);
+}
+
+static uint
+stroke_cache_hash(const fixed *key, int size)
+{
+    uint hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < size; i++)
+        hash = (hash ^ (uint)key[i]) * 16777619u;
+    return (hash == 0 ? 1 : hash);
+}
+
+/* Append a recorded outline to to_path, translated to origin. */
+static int
+stroke_cache_replay(gx_path *to_path, const fixed *outline, int size,
+                    const gs_fixed_point *origin)
+{
+    int i = 0;
+    int code = 0;
+
+    while (i < size && code >= 0) {
+        int info = (int)outline[i];
+        segment_notes notes = (segment_notes)((info >> 8) & 0xffff);
+        fixed x = outline[i + 1] + origin->x;
+        fixed y = outline[i + 2] + origin->y;
+
+        switch (info & 0xff) {
+            case s_start:
+                code = gx_path_add_point(to_path, x, y);
+                break;
+            case s_line:
+                code = gx_path_add_line_notes(to_path, x, y, notes);
+                break;
+            case s_line_close:
+                code = gx_path_close_subpath_notes(to_path, notes);
+                break;
+            case s_curve:
+                code = gx_path_add_curve_notes(to_path, x, y,
+                                               outline[i + 3] + origin->x,
+                                               outline[i + 4] + origin->y,
+                                               outline[i + 5] + origin->x,
+                                               outline[i + 6] + origin->y,
+                                               notes);
+                i += 4;
+                break;
+            default:
+                return_error(gs_error_unregistered);
+        }
+        i += 3;
+    }
+    return code;
+}
+
+/*
+ * Look up a stroke.  On a hit, append the outline to to_path, set *pcode
+ * to the result and return true.
+ */
+static bool
+stroke_cache_lookup(gs_lib_ctx_core_t *core, uint hash, const fixed *key,
+                    int key_size, gx_path *to_path,
+                    const gs_fixed_point *origin, gx_device *pdev, int *pcode)
+{
+    stroke_cache_t *cache;
+    bool found = false;
+    int i;
+
+    gx_monitor_enter((gx_monitor_t *)core->monitor);
+    cache = (stroke_cache_t *)core->stroke_cache;
+    if (cache != NULL) {
+        for (i = 0; i < STROKE_CACHE_SIZE; i++) {
+            stroke_cache_entry_t *pe = &cache->entries[i];
+
+            if (pe->hash != hash || pe->key_size != key_size ||
+                memcmp(pe->key, key, key_size * sizeof(fixed)))
+                continue;
+            *pcode = stroke_cache_replay(to_path, pe->outline,
+                                         pe->outline_size, origin);
+            stroke_cache_set_sgr(pdev, pe->sgr_mode, &pe->sgr, origin);
+            pe->last_used = ++cache->clock;
+            found = true;
+            break;
+        }
+    }
+    gx_monitor_leave((gx_monitor_t *)core->monitor);
+    return found;
+}
+
+/*
+ * Remember the outline of a stroke, replacing the least recently used
+ * entry.  Failure to allocate just means no caching.
+ */
+static void
+stroke_cache_store(gs_lib_ctx_core_t *core, uint hash, const fixed *key,
+                   int key_size, const gx_path *to_path,
+                   const gs_fixed_point *origin, int sgr_mode,
+                   const gx_stroked_gradient_recognizer_t *sgr)
+{
+    gs_memory_t *mem = core->memory;
+    int outline_size = stroke_cache_put_path(to_path, origin, NULL, 0,
+                                             STROKE_CACHE_MAX_OUTLINE);
+    stroke_cache_t *cache;
+    stroke_cache_entry_t *pe;
+    fixed *block;
+    int i;
+
+    /* The outline must end on its last segment for replay to */
+    /* leave to_path in the same state. */
+    if (outline_size <= 0 || path_outside_range(to_path) ||
+        to_path->position.x != to_path->current_subpath->last->pt.x ||
+        to_path->position.y != to_path->current_subpath->last->pt.y)
+        return;
+    block = (fixed *)gs_alloc_bytes(mem,
+                                    (key_size + outline_size) * sizeof(fixed),
+                                    "stroke_cache_store");
+    if (block == NULL)
+        return;
+    memcpy(block, key, key_size * sizeof(fixed));
+    stroke_cache_put_path(to_path, origin, block + key_size, 0, outline_size);
+
+    gx_monitor_enter((gx_monitor_t *)core->monitor);
+    cache = (stroke_cache_t *)core->stroke_cache;
+    if (cache == NULL) {
+        cache = (stroke_cache_t *)gs_alloc_bytes(mem, sizeof(*cache),
+                                                 "stroke_cache_store");
+        if (cache == NULL) {
+            gx_monitor_leave((gx_monitor_t *)core->monitor);
+            gs_free_object(mem, block, "stroke_cache_store");
+            return;
+        }
+        memset(cache, 0, sizeof(*cache));
+        core->stroke_cache = cache;
+        core->stroke_cache_free = stroke_cache_free;
+    }
+    pe = &cache->entries[0];
+    for (i = 0; i < STROKE_CACHE_SIZE; i++) {
+        stroke_cache_entry_t *pi = &cache->entries[i];
+
+        /* Another thread may have stored the same stroke meanwhile. */
+        if (pi->hash == hash && pi->key_size == key_size &&
+            !memcmp(pi->key, key, key_size * sizeof(fixed))) {
+            gx_monitor_leave((gx_monitor_t *)core->monitor);
+            gs_free_object(mem, block, "stroke_cache_store");
+            return;
+        }
+        if (pi->hash == 0 || pi->last_used < pe->last_used)
+            pe = pi;
+    }
+    gs_free_object(mem, pe->key, "stroke_cache_store(evict)");
+    pe->hash = hash;
+    pe->key_size = key_size;
+    pe->outline_size = outline_size;
+    pe->sgr_mode = sgr_mode;
+    if (sgr_mode == 2) {
+        pe->sgr = *sgr;
+        stroke_cache_translate_sgr(&pe->sgr, -origin->x, -origin->y);
+    }
+    pe->key = block;
+    pe->outline = block + key_size;
+    pe->last_used = ++cache->clock;
+    gx_monitor_leave((gx_monitor_t *)core->monitor);
+}
+
 int
 gx_stroke_path_only(gx_path * ppath, gx_path * to_path, gx_device * pdev,
                const gs_gstate * pgs, const gx_stroke_params * params,
                  const gx_device_color * pdevc, const gx_clip_path * pcpath)
 {
-    return gx_stroke_path_only_aux(ppath, to_path, pdev, pgs, params, pdevc, pcpath);
+    gs_lib_ctx_core_t *core = NULL;
+    fixed key[STROKE_CACHE_MAX_KEY];
+    int key_size = -1;
+    gs_fixed_point origin;
+    uint hash = 0;
+    bool stroke_stored;
+    int sgr_mode;
+    int code;
+
+    /* Only cache complete outlines built into an empty path. */
+    if (to_path != 0 && pdevc == 0 && pcpath == 0 &&
+        gx_path_is_void(to_path) && ppath->first_subpath != 0 &&
+        pgs->memory->gs_lib_ctx != NULL &&
+        pgs->memory->gs_lib_ctx->core->monitor != NULL)
+        core = pgs->memory->gs_lib_ctx->core;
+    if (core != NULL) {
+        origin.x = fixed_floor(ppath->first_subpath->pt.x);
+        origin.y = fixed_floor(ppath->first_subpath->pt.y);
+        key_size = stroke_cache_key(ppath, pdev, pgs, params, &origin, key);
+    }
+    if (key_size <= 0)
+        return gx_stroke_path_only_aux(ppath, to_path, pdev, pgs, params,
+                                       pdevc, pcpath);
+    hash = stroke_cache_hash(key, key_size);
+    if (stroke_cache_lookup(core, hash, key, key_size, to_path, &origin,
+                            pdev, &code)) {
+        if_debug1m('o', ppath->memory, "[o]stroke cache hit, key size %d\n",
+                   key_size);
+        return code;
+    }
+    if (pgs->stroke_adjust) {
+        code = gx_stroke_path_only_aux(ppath, to_path, pdev, pgs, params,
+                                       pdevc, pcpath);
+        sgr_mode = (pdev->sgr.stroke_stored ? 2 : 1);
+    } else {
+        /*
+         * Without stroke adjustment the stroker never reads dev->sgr, it
+         * only clears stroke_stored, so find out whether it does.
+         */
+        stroke_stored = pdev->sgr.stroke_stored;
+        pdev->sgr.stroke_stored = true;
+        code = gx_stroke_path_only_aux(ppath, to_path, pdev, pgs, params,
+                                       pdevc, pcpath);
+        sgr_mode = (pdev->sgr.stroke_stored ? 0 : 1);
+        if (sgr_mode == 0)
+            pdev->sgr.stroke_stored = stroke_stored;
+    }
+    if (code >= 0 && !gx_path_is_void(to_path))
+        stroke_cache_store(core, hash, key, key_size, to_path, &origin,
+                           sgr_mode, &pdev->sgr);
+    return code;
 }
 
 /* ------ Internal routines ------ */
@@ -1395,6 +1849,33 @@ set_thin_widths(register pl_ptr plp)
 #undef TRSIGN
 }
 
+/*
+ * Check whether a stroke segment that is a device space rectangle may be
+ * filled as such, i.e. whether the general case would fill its path with
+ * gx_default_fill_path and the edge buffer scan converter using the
+ * standard fill adjustment, in a color whose rectangles look the same
+ * however they are divided up.
+ */
+#define STROKE_RECT_OK(v)\
+  ((v) > -(max_fixed >> 2) && (v) < (max_fixed >> 2))
+static bool
+stroke_fill_by_rectangles(gx_device *dev, const gs_gstate *pgs,
+                          const gx_device_color *pdevc)
+{
+    int scanconverter;
+
+    if (pgs->fill_adjust.x != fixed_half || pgs->fill_adjust.y != fixed_half ||
+        !(gx_dc_is_pure(pdevc) || gx_dc_is_devn(pdevc) ||
+          gx_dc_is_binary_halftone(pdevc)) ||
+        dev_proc(dev, fill_path) != gx_default_fill_path ||
+        dev_proc(dev, open_device) == san_open)
+        return false;
+    scanconverter = gs_getscanconverter(dev->memory);
+    return (scanconverter >= GS_SCANCONVERTER_EDGEBUFFER ||
+            (scanconverter == GS_SCANCONVERTER_DEFAULT &&
+             GS_SCANCONVERTER_DEFAULT_IS_EDGEBUFFER));
+}
+
 /* Draw a line on the device. */
 /* Treat no join the same as a bevel join. */
 /* rpath should always be NULL, hence ensure_closed can be ignored */
@@ -1431,6 +1912,45 @@ stroke_fill(gx_path * ppath, gx_path * rpath, bool ensure_closed, int first,
             start_cap = gs_cap_butt;
         if (nplp != 0)
             end_cap = gs_cap_butt;
+        /*
+         * A horizontal or vertical segment with butt or square caps and
+         * no join (grid and table rules, and the dashes of dashed ones)
+         * is a rectangle.  When the general case would scan convert it
+         * with the any-part-of-pixel adjustment, it covers exactly the
+         * pixels the rectangle touches, so fill those directly rather
+         * than building a path for the fill algorithm.
+         */
+        if (nplp == 0
+            && (start_cap == gs_cap_butt || start_cap == gs_cap_square)
+            && (end_cap   == gs_cap_butt || end_cap   == gs_cap_square)
+            && stroke_fill_by_rectangles(dev, pgs, pdevc)
+            ) {
+            gs_fixed_point points[4];
+            gs_fixed_rect r;
+
+            cap_points(start_cap, &plp->o, points);
+            cap_points(end_cap, &plp->e, points + 2);
+            r.p.x = min(points[0].x, points[2].x);
+            r.p.y = min(points[0].y, points[2].y);
+            r.q.x = max(points[0].x, points[2].x);
+            r.q.y = max(points[0].y, points[2].y);
+            /* The four corners must be exactly those of the rectangle. */
+            if (r.p.x < r.q.x && r.p.y < r.q.y &&
+                ((points[0].x == points[1].x && points[2].x == points[3].x &&
+                  points[0].y == points[3].y && points[1].y == points[2].y) ||
+                 (points[0].y == points[1].y && points[2].y == points[3].y &&
+                  points[0].x == points[3].x && points[1].x == points[2].x)) &&
+                STROKE_RECT_OK(r.p.x) && STROKE_RECT_OK(r.p.y) &&
+                STROKE_RECT_OK(r.q.x) && STROKE_RECT_OK(r.q.y)
+                ) {
+                int x0 = fixed2int_var(r.p.x), y0 = fixed2int_var(r.p.y);
+
+                return gx_fill_rectangle_device_rop(x0, y0,
+                                        fixed2int_var_ceiling(r.q.x) - x0,
+                                        fixed2int_var_ceiling(r.q.y) - y0,
+                                        pdevc, dev, pgs->log_op);
+            }
+        }
         if (!plp->thin && (nplp == 0 || !nplp->thin)
             && (start_cap == gs_cap_butt || start_cap == gs_cap_square)
             && (end_cap   == gs_cap_butt || end_cap   == gs_cap_square)
@@ -445,6 +445,8 @@ int ttfFont__Open_aux(ttfFont *self, ttfInterpreter *tti, gx_ttfReader *r, gs_fo
     bool dg;
 
     decompose_matrix(pfont, char_tm, log2_scale, design_grid, &char_size, &subpix_origin, &post_transform, &dg);
+    /* Fm pairs of the same font share the results of its prep program. */
+    self->nFontId = pfont->id;
     switch(ttfFont__Open(tti, self, &r->super, nTTC, char_size.x, char_size.y, dg)) {
         case fNoError:
             return 0;
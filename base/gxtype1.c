@@ -338,6 +338,171 @@ type1_cis_get_metrics(const gs_type1_state * pcis, double psbw[4])
     psbw[3] = fixed2float(pcis->width.y);
 }
 
+/* ------ Outline cache ------ */
+
+/*
+ * Each base font that has rendered a Type 1 glyph keeps a small hash
+ * table of outline tapes (see gxtype1.h), registered on the font's
+ * notification list so that it is freed together with the font.  The
+ * cache structure lives in stable memory; the tapes, which contain no
+ * pointers the garbage collector needs to see, are allocated in non-GC
+ * memory.  When the cache exceeds type1_outline_cache_max bytes, the
+ * oldest tapes are discarded first.
+ */
+#define type1_outline_hash_size 64
+#define type1_outline_cache_max 0x20000
+
+typedef struct type1_outline_s type1_outline;
+struct type1_outline_s {
+    type1_outline *next;	/* next in hash chain */
+    type1_outline *newer;	/* next in order of creation */
+    uint hash;
+    uint cs_size;		/* size of the charstring */
+    uint ip_offset;		/* position just after hsbw/sbw */
+    int length;			/* # of fixed values in the tape */
+    /* fixed tape[length] and byte cs[cs_size] follow. */
+};
+#define type1_outline_tape(po) ((fixed *)((po) + 1))
+#define type1_outline_cs(po) ((byte *)(type1_outline_tape(po) + (po)->length))
+
+typedef struct type1_outline_cache_s {
+    gs_memory_t *memory;	/* allocator of this structure */
+    uint total_size;
+    type1_outline *oldest, *newest;
+    type1_outline *table[type1_outline_hash_size];
+} type1_outline_cache;
+gs_private_st_simple(st_type1_outline_cache, type1_outline_cache,
+                     "type1_outline_cache");
+
+static GS_NOTIFY_PROC(type1_outline_cache_release);
+
+static type1_outline_cache *
+type1_outline_cache_find(gs_font *font)
+{
+    gs_notify_registration_t *nreg = font->notify_list.first;
+
+    for (; nreg != 0; nreg = nreg->next)
+        if (nreg->proc == type1_outline_cache_release)
+            return (type1_outline_cache *)nreg->proc_data;
+    return 0;
+}
+
+static uint
+type1_outline_hash(const gs_const_bytestring *cs, uint ip_offset)
+{
+    uint hash = ip_offset;
+    uint i;
+
+    for (i = 0; i < cs->size; i++)
+        hash = hash * 31 + cs->data[i];
+    return hash;
+}
+
+/* Discard the oldest tape. */
+static void
+type1_outline_discard(type1_outline_cache *pcache)
+{
+    type1_outline *po = pcache->oldest;
+    type1_outline **ppo = &pcache->table[po->hash % type1_outline_hash_size];
+
+    while (*ppo != po)
+        ppo = &(*ppo)->next;
+    *ppo = po->next;
+    pcache->oldest = po->newer;
+    if (pcache->oldest == 0)
+        pcache->newest = 0;
+    pcache->total_size -= sizeof(type1_outline) + po->length * sizeof(fixed) +
+        po->cs_size;
+    gs_free_object(pcache->memory->non_gc_memory, po, "type1_outline_discard");
+}
+
+static int
+type1_outline_cache_release(void *data, void *event)
+{
+    type1_outline_cache *pcache = (type1_outline_cache *)data;
+
+    while (pcache->oldest != 0)
+        type1_outline_discard(pcache);
+    gs_free_object(pcache->memory, pcache, "type1_outline_cache_release");
+    return 0;
+}
+
+int
+gs_type1_outline_lookup(gs_font_type1 *pfont, const gs_const_bytestring *cs,
+                        uint ip_offset, const fixed **ptape, int *plength)
+{
+    type1_outline_cache *pcache = type1_outline_cache_find(pfont->base);
+    type1_outline *po;
+    uint hash;
+
+    if (pcache == 0)
+        return 0;
+    hash = type1_outline_hash(cs, ip_offset);
+    for (po = pcache->table[hash % type1_outline_hash_size]; po != 0;
+         po = po->next)
+        if (po->hash == hash && po->ip_offset == ip_offset &&
+            po->cs_size == cs->size &&
+            !memcmp(type1_outline_cs(po), cs->data, cs->size)
+            ) {
+            *ptape = type1_outline_tape(po);
+            *plength = po->length;
+            return 1;
+        }
+    return 0;
+}
+
+void
+gs_type1_outline_store(gs_font_type1 *pfont, const gs_const_bytestring *cs,
+                       uint ip_offset, const fixed *tape, int length)
+{
+    gs_font *base = pfont->base;
+    type1_outline_cache *pcache = type1_outline_cache_find(base);
+    uint size = sizeof(type1_outline) + length * sizeof(fixed) + cs->size;
+    type1_outline *po;
+    uint hash;
+
+    if (size > type1_outline_cache_max)
+        return;
+    if (pcache == 0) {
+        gs_memory_t *mem = base->memory->stable_memory;
+
+        pcache = gs_alloc_struct(mem, type1_outline_cache,
+                                 &st_type1_outline_cache,
+                                 "gs_type1_outline_store");
+        if (pcache == 0)
+            return;
+        memset(pcache, 0, sizeof(*pcache));
+        pcache->memory = mem;
+        if (gs_font_notify_register(base, type1_outline_cache_release,
+                                    (void *)pcache) < 0) {
+            gs_free_object(mem, pcache, "gs_type1_outline_store");
+            return;
+        }
+    }
+    while (pcache->total_size + size > type1_outline_cache_max)
+        type1_outline_discard(pcache);
+    po = (type1_outline *)gs_alloc_bytes(pcache->memory->non_gc_memory, size,
+                                         "gs_type1_outline_store");
+    if (po == 0)
+        return;
+    hash = type1_outline_hash(cs, ip_offset);
+    po->hash = hash;
+    po->cs_size = cs->size;
+    po->ip_offset = ip_offset;
+    po->length = length;
+    memcpy(type1_outline_tape(po), tape, length * sizeof(fixed));
+    memcpy(type1_outline_cs(po), cs->data, cs->size);
+    po->next = pcache->table[hash % type1_outline_hash_size];
+    pcache->table[hash % type1_outline_hash_size] = po;
+    po->newer = 0;
+    if (pcache->newest == 0)
+        pcache->oldest = po;
+    else
+        pcache->newest->newer = po;
+    pcache->newest = po;
+    pcache->total_size += size;
+}
+
 /* ------ Font procedures ------ */
 
 /*
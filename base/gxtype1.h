@@ -280,4 +280,25 @@ int gs_type1_endchar(gs_type1_state * pcis);
 /* Get the metrics (l.s.b. and width) from the Type 1 interpreter. */
 void type1_cis_get_metrics(const gs_type1_state * pcis, double psbw[4]);
 
+/* ------ Outline cache ------ */
+
+/*
+ * The Type 1 interpreter can record the hinter calls a charstring makes
+ * after its hsbw/sbw (with all Subrs expanded) as a "tape" of fixed
+ * values in character space.  The tapes are kept per base font, keyed by
+ * the charstring bytes, so that rendering the same glyph at another size
+ * or transformation replays the tape into the hinter instead of
+ * re-interpreting the charstring.  The format of the tape is private to
+ * the interpreter.
+ */
+#define type1_outline_tape_max 2048	/* max # of fixed values in a tape */
+
+/* Look up a tape; return 1 and set *ptape, *plength if found, else 0. */
+int gs_type1_outline_lookup(gs_font_type1 *pfont, const gs_const_bytestring *cs,
+                            uint ip_offset, const fixed **ptape, int *plength);
+
+/* Store a tape.  Failure to store is not an error. */
+void gs_type1_outline_store(gs_font_type1 *pfont, const gs_const_bytestring *cs,
+                            uint ip_offset, const fixed *tape, int length);
+
 #endif /* gxtype1_INCLUDED */
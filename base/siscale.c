@@ -24,6 +24,22 @@
 #include "siscale.h"
 #include "gxfrac.h"
 
+#ifdef HAVE_SSE2
+#define ISCALE_SSE2
+#include <emmintrin.h>
+/* AVX2 kernels are compiled for their own instruction set only (via the
+   target attribute), and are selected at run time if the CPU supports
+   them, so that the build still runs on plain SSE2 machines. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ISCALE_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+/* NEON is always present on AArch64, so no run time check is needed. */
+#define ISCALE_NEON
+#include <arm_neon.h>
+#endif
+
 /*
  *    Image scaling code is based on public domain code from
  *      Graphics Gems III (pp. 414-424), Academic Press, 1992.
@@ -53,7 +69,7 @@ typedef void (zoom_y_fn)(void *dst,
        int Colors, const CLIST * gs_restrict contrib, const CONTRIB * gs_restrict items);
 typedef void (zoom_x_fn)(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
        int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
-       const CONTRIB * gs_restrict items);
+       const CONTRIB * gs_restrict items, const int * gs_restrict pairs);
 
 /* ImageScaleEncode / ImageScaleDecode */
 typedef struct stream_IScale_state_s {
@@ -67,6 +83,7 @@ typedef struct stream_IScale_state_s {
     byte *tmp;
     CLIST *contrib;
     CONTRIB *items;
+    int *pairs;                 /* items packed in 16 bit pairs, or 0 */
     /* The following are updated dynamically. */
     int src_y;
     uint src_offset, src_size;
@@ -85,10 +102,10 @@ typedef struct stream_IScale_state_s {
     zoom_x_fn *zoom_x;
 } stream_IScale_state;
 
-gs_private_st_ptrs6(st_IScale_state, stream_IScale_state,
+gs_private_st_ptrs7(st_IScale_state, stream_IScale_state,
     "ImageScaleEncode/Decode state",
     iscale_state_enum_ptrs, iscale_state_reloc_ptrs,
-    dst, src, tmp, contrib, items, dst_items);
+    dst, src, tmp, contrib, items, dst_items, pairs);
 
 /* ------ Digital filter definition ------ */
 
@@ -305,7 +322,7 @@ calculate_contrib(
 static void
 zoom_x1(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
                  int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
-                 const CONTRIB * gs_restrict items)
+                 const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
 {
     int c, i;
 
@@ -338,7 +355,7 @@ zoom_x1(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
 static void
 zoom_x1_1(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
           int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
-          const CONTRIB * gs_restrict items)
+          const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
 {
     contrib += skip;
     tmp += Colors * skip;
@@ -364,7 +381,7 @@ zoom_x1_1(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
 static void
 zoom_x1_3(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
           int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
-          const CONTRIB * gs_restrict items)
+          const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
 {
     contrib += skip;
     tmp += Colors * skip;
@@ -399,7 +416,7 @@ zoom_x1_3(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
 static void
 zoom_x1_4(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
           int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
-          const CONTRIB * gs_restrict items)
+          const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
 {
     contrib += skip;
     tmp += Colors * skip;
@@ -438,7 +455,7 @@ zoom_x1_4(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
 static void
 zoom_x2(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
         int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
-        const CONTRIB * gs_restrict items)
+        const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
 {
     int c, i;
 
@@ -478,6 +495,443 @@ zoom_x2(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
     }
 }
 
+/*
+ * SIMD versions of the above.  These give exactly the same results as the
+ * scalar loops: the sums are formed in 32 bits from the same products, and
+ * are rounded, shifted and clamped in the same way.  On x86, 8 bit samples
+ * are multiplied in 16 bit pairs (madd), two taps at a time, so the
+ * weights are packed into pairs, low tap in the low half.
+ */
+#if defined(ISCALE_SSE2) || defined(ISCALE_NEON)
+#define ISCALE_SIMD
+#endif
+
+#define PACK_PAIR(w0, w1)\
+  ((int)(((unsigned int)(w1) << 16) | ((unsigned int)(w0) & 0xffff)))
+#define FITS_16(w) ((w) >= -32768 && (w) <= 32767)
+
+#ifdef ISCALE_SSE2
+/* Pack the horizontal weights into pairs, indexed as for items.  A list
+ * of n weights takes (n + 1) / 2 pairs, which always fits in the space
+ * items gives it.  Returns 0 if any weight is too big for 16 bits. */
+static int *
+calculate_pairs(gs_memory_t *mem, const CLIST * contrib, const CONTRIB * items,
+                int size, int count)
+{
+    int *pairs = (int *)gs_alloc_byte_array(mem, count, sizeof(int),
+                                            "image_scale pairs");
+    int i, j;
+
+    if (pairs == 0)
+        return 0;
+    for (i = 0; i < size; ++i) {
+        const CONTRIB *cp = items + contrib[i].index;
+        int *pp = pairs + contrib[i].index;
+        int n = contrib[i].n;
+
+        for (j = 0; j < n; j += 2) {
+            int w0 = cp[j].weight;
+            int w1 = (j + 1 < n ? cp[j + 1].weight : 0);
+
+            if (!FITS_16(w0) || !FITS_16(w1)) {
+                gs_free_object(mem, pairs, "image_scale pairs");
+                return 0;
+            }
+            *pp++ = PACK_PAIR(w0, w1);
+        }
+    }
+    return pairs;
+}
+
+/* Two pixels of 3 or 4 samples from pp, as 16 bit values with the samples
+ * of the two interleaved. Only reads beyond the two pixels if more is
+ * there. */
+static inline __m128i
+zoom_x_load_2(const byte * gs_restrict pp, int Colors, bool more)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i px;
+
+    if (Colors == 4 || more)
+        px = _mm_loadl_epi64((const __m128i *)pp);
+    else {
+        byte buf[8];
+
+        memcpy(buf, pp, 6);
+        buf[6] = buf[7] = 0;
+        px = _mm_loadl_epi64((const __m128i *)buf);
+    }
+    px = _mm_unpacklo_epi8(px, zero);
+    if (Colors == 4)
+        return _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+    return _mm_unpacklo_epi16(px, _mm_srli_si128(px, 6));
+}
+
+static inline void
+zoom_x1_34_SSE2(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
+                int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
+                const int * gs_restrict pairs)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    contrib += skip;
+    tmp += Colors * skip;
+
+    for ( ; tmp_width != 0; --tmp_width ) {
+        int j = contrib->n;
+        const byte *gs_restrict pp = ((const byte *)src) + contrib->first_pixel;
+        const int *gs_restrict wp = pairs + (contrib++)->index;
+        __m128i sum = _mm_set1_epi32(CONTRIB_ROUND);
+        int v;
+
+        for ( ; j >= 2; j -= 2, pp += 2 * Colors) {
+            __m128i px = zoom_x_load_2(pp, Colors, j > 2);
+
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(px, _mm_set1_epi32(*wp++)));
+        }
+        if (j) {
+            __m128i px;
+
+            v = pp[0] | (pp[1] << 8) | (pp[2] << 16);
+            if (Colors == 4)
+                v |= pp[3] << 24;
+            px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero);
+            px = _mm_unpacklo_epi16(px, zero);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(px, _mm_set1_epi32(*wp)));
+        }
+        sum = _mm_srai_epi32(sum, CONTRIB_SHIFT);
+        sum = _mm_packs_epi32(sum, sum);
+        v = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+        *tmp++ = (byte)v;
+        *tmp++ = (byte)(v >> 8);
+        *tmp++ = (byte)(v >> 16);
+        if (Colors == 4)
+            *tmp++ = (byte)(v >> 24);
+    }
+}
+
+static void
+zoom_x1_3_SSE2(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
+               int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
+               const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
+{
+    zoom_x1_34_SSE2(tmp, src, skip, tmp_width, 3, contrib, pairs);
+}
+
+static void
+zoom_x1_4_SSE2(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
+               int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
+               const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
+{
+    zoom_x1_34_SSE2(tmp, src, skip, tmp_width, 4, contrib, pairs);
+}
+#endif /* ISCALE_SSE2 */
+
+#ifdef ISCALE_NEON
+static inline void
+zoom_x1_34_NEON(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
+                int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
+                const CONTRIB * gs_restrict items)
+{
+    contrib += skip;
+    tmp += Colors * skip;
+
+    for ( ; tmp_width != 0; --tmp_width ) {
+        int j = contrib->n;
+        const byte *gs_restrict pp = ((const byte *)src) + contrib->first_pixel;
+        const CONTRIB *gs_restrict cp = items + (contrib++)->index;
+        int32x4_t sum = vdupq_n_s32(CONTRIB_ROUND);
+        uint8x8_t out;
+
+        for ( ; j > 0; pp += Colors, ++cp, --j ) {
+            uint32_t v = pp[0] | (pp[1] << 8) | (pp[2] << 16);
+            uint16x8_t px;
+
+            if (Colors == 4)
+                v |= (uint32_t)pp[3] << 24;
+            px = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v)));
+            sum = vmlaq_n_s32(sum, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(px))),
+                              cp->weight);
+        }
+        sum = vshrq_n_s32(sum, CONTRIB_SHIFT);
+        out = vqmovn_u16(vcombine_u16(vqmovun_s32(sum), vqmovun_s32(sum)));
+        *tmp++ = vget_lane_u8(out, 0);
+        *tmp++ = vget_lane_u8(out, 1);
+        *tmp++ = vget_lane_u8(out, 2);
+        if (Colors == 4)
+            *tmp++ = vget_lane_u8(out, 3);
+    }
+}
+
+static void
+zoom_x1_3_NEON(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
+               int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
+               const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
+{
+    zoom_x1_34_NEON(tmp, src, skip, tmp_width, 3, contrib, items);
+}
+
+static void
+zoom_x1_4_NEON(byte * gs_restrict tmp, const void /*PixelIn */ * gs_restrict src,
+               int skip, int tmp_width, int Colors, const CLIST * gs_restrict contrib,
+               const CONTRIB * gs_restrict items, const int * gs_restrict pairs)
+{
+    zoom_x1_34_NEON(tmp, src, skip, tmp_width, 4, contrib, items);
+}
+#endif /* ISCALE_NEON */
+
+/*
+ * The vertical SIMD kernels do whole groups of 8 (or 16) samples of a row
+ * of n taps, kn bytes apart in tmp, and return how many samples they did.
+ * Output samples are sizeofPixelOut bytes, clamped to 0..maxval.
+ */
+#ifdef ISCALE_SSE2
+/* Rows with more taps than this are left to the scalar code. */
+#define ZOOM_Y_SIMD_MAX_TAPS 16
+
+/* Pack the vertical weights into pairs.  Weights that don't fit in 16 bits
+ * are split into their low 15 bits (lo) and the rest (hi), to be
+ * recombined after the madds.  Returns true if they needed splitting. */
+static bool
+zoom_y_pairs(int *lo, int *hi, const CONTRIB * gs_restrict cbp, int n)
+{
+    bool wide = false;
+    int j;
+
+    for (j = 0; j < n; ++j)
+        if (!FITS_16(cbp[j].weight))
+            wide = true;
+    for (j = 0; j < n; j += 2) {
+        int w0 = cbp[j].weight;
+        int w1 = (j + 1 < n ? cbp[j + 1].weight : 0);
+
+        if (wide) {
+            *lo++ = PACK_PAIR(w0 & 0x7fff, w1 & 0x7fff);
+            *hi++ = PACK_PAIR(w0 >> 15, w1 >> 15);
+        } else
+            *lo++ = PACK_PAIR(w0, w1);
+    }
+    return wide;
+}
+
+static int
+zoom_y_SSE2(void /*PixelOut */ * gs_restrict dst, const byte * gs_restrict tmp,
+            int width, int kn, int n, const CONTRIB * gs_restrict cbp,
+            int sizeofPixelOut, int maxval)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(CONTRIB_ROUND);
+    const __m128i max_out = _mm_set1_epi32(maxval);
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    const __m128i unbias = _mm_set1_epi16((short)0x8000);
+    int lo[ZOOM_Y_SIMD_MAX_TAPS / 2], hi[ZOOM_Y_SIMD_MAX_TAPS / 2];
+    int npairs = (n + 1) / 2;
+    bool wide;
+    int x, k;
+
+    if (n > ZOOM_Y_SIMD_MAX_TAPS)
+        return 0;
+    wide = zoom_y_pairs(lo, hi, cbp, n);
+    for (x = 0; x + 8 <= width; x += 8) {
+        const byte *gs_restrict pp = tmp + x;
+        __m128i sum0 = round, sum1 = round;
+        __m128i hsum0 = zero, hsum1 = zero;
+
+        for (k = 0; k < npairs; ++k, pp += 2 * kn) {
+            __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)pp), zero);
+            __m128i b = zero;
+            __m128i ab0, ab1, w;
+
+            if (2 * k + 1 < n)
+                b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(pp + kn)), zero);
+            ab0 = _mm_unpacklo_epi16(a, b);
+            ab1 = _mm_unpackhi_epi16(a, b);
+            w = _mm_set1_epi32(lo[k]);
+            sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(ab0, w));
+            sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(ab1, w));
+            if (wide) {
+                w = _mm_set1_epi32(hi[k]);
+                hsum0 = _mm_add_epi32(hsum0, _mm_madd_epi16(ab0, w));
+                hsum1 = _mm_add_epi32(hsum1, _mm_madd_epi16(ab1, w));
+            }
+        }
+        if (wide) {
+            sum0 = _mm_add_epi32(sum0, _mm_slli_epi32(hsum0, 15));
+            sum1 = _mm_add_epi32(sum1, _mm_slli_epi32(hsum1, 15));
+        }
+        sum0 = _mm_srai_epi32(sum0, CONTRIB_SHIFT);
+        sum1 = _mm_srai_epi32(sum1, CONTRIB_SHIFT);
+        if (sizeofPixelOut == 1) {
+            /* The saturating packs clamp to 0..255 for us. */
+            sum0 = _mm_packs_epi32(sum0, sum1);
+            _mm_storel_epi64((__m128i *)((byte *)dst + x), _mm_packus_epi16(sum0, sum0));
+        } else {
+            __m128i over;
+
+            /* Clamp to 0..maxval, then pack with a bias, as SSE2 only
+               has a signed pack from 32 bits. */
+            sum0 = _mm_andnot_si128(_mm_srai_epi32(sum0, 31), sum0);
+            sum1 = _mm_andnot_si128(_mm_srai_epi32(sum1, 31), sum1);
+            over = _mm_cmpgt_epi32(sum0, max_out);
+            sum0 = _mm_or_si128(_mm_and_si128(over, max_out), _mm_andnot_si128(over, sum0));
+            over = _mm_cmpgt_epi32(sum1, max_out);
+            sum1 = _mm_or_si128(_mm_and_si128(over, max_out), _mm_andnot_si128(over, sum1));
+            sum0 = _mm_packs_epi32(_mm_sub_epi32(sum0, bias), _mm_sub_epi32(sum1, bias));
+            _mm_storeu_si128((__m128i *)((bits16 *)dst + x), _mm_xor_si128(sum0, unbias));
+        }
+    }
+    return x;
+}
+
+#ifdef ISCALE_AVX2
+__attribute__((target("avx2")))
+static int
+zoom_y_AVX2(void /*PixelOut */ * gs_restrict dst, const byte * gs_restrict tmp,
+            int width, int kn, int n, const CONTRIB * gs_restrict cbp,
+            int sizeofPixelOut, int maxval)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(CONTRIB_ROUND);
+    const __m256i max_out = _mm256_set1_epi32(maxval);
+    int lo[ZOOM_Y_SIMD_MAX_TAPS / 2], hi[ZOOM_Y_SIMD_MAX_TAPS / 2];
+    int npairs = (n + 1) / 2;
+    bool wide;
+    int x, k;
+
+    if (n > ZOOM_Y_SIMD_MAX_TAPS)
+        return 0;
+    wide = zoom_y_pairs(lo, hi, cbp, n);
+    for (x = 0; x + 16 <= width; x += 16) {
+        const byte *gs_restrict pp = tmp + x;
+        __m256i sum0 = round, sum1 = round;
+        __m256i hsum0 = zero, hsum1 = zero;
+
+        for (k = 0; k < npairs; ++k, pp += 2 * kn) {
+            __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)pp));
+            __m256i b = zero;
+            __m256i ab0, ab1, w;
+
+            if (2 * k + 1 < n)
+                b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(pp + kn)));
+            /* Within each 128 bit lane, so ab0 holds samples 0-3 and 8-11,
+               ab1 4-7 and 12-15. The packs below put them back in order. */
+            ab0 = _mm256_unpacklo_epi16(a, b);
+            ab1 = _mm256_unpackhi_epi16(a, b);
+            w = _mm256_set1_epi32(lo[k]);
+            sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(ab0, w));
+            sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(ab1, w));
+            if (wide) {
+                w = _mm256_set1_epi32(hi[k]);
+                hsum0 = _mm256_add_epi32(hsum0, _mm256_madd_epi16(ab0, w));
+                hsum1 = _mm256_add_epi32(hsum1, _mm256_madd_epi16(ab1, w));
+            }
+        }
+        if (wide) {
+            sum0 = _mm256_add_epi32(sum0, _mm256_slli_epi32(hsum0, 15));
+            sum1 = _mm256_add_epi32(sum1, _mm256_slli_epi32(hsum1, 15));
+        }
+        sum0 = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(sum0, CONTRIB_SHIFT), zero), max_out);
+        sum1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(sum1, CONTRIB_SHIFT), zero), max_out);
+        sum0 = _mm256_packus_epi32(sum0, sum1);
+        if (sizeofPixelOut == 1) {
+            sum0 = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum0, sum0), 0xd8);
+            _mm_storeu_si128((__m128i *)((byte *)dst + x), _mm256_castsi256_si128(sum0));
+        } else
+            _mm256_storeu_si256((__m256i *)((bits16 *)dst + x), sum0);
+    }
+    return x;
+}
+
+/* Racing threads will all store the same value. */
+static int
+zoom_y_use_avx2(void)
+{
+    static int avx2 = -1;
+
+    if (avx2 < 0) {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") != 0;
+    }
+    return avx2;
+}
+#endif /* ISCALE_AVX2 */
+#endif /* ISCALE_SSE2 */
+
+#ifdef ISCALE_NEON
+static int
+zoom_y_NEON(void /*PixelOut */ * gs_restrict dst, const byte * gs_restrict tmp,
+            int width, int kn, int n, const CONTRIB * gs_restrict cbp,
+            int sizeofPixelOut, int maxval)
+{
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max_out = vdupq_n_s32(maxval);
+    int x, j;
+
+    for (x = 0; x + 8 <= width; x += 8) {
+        const byte *gs_restrict pp = tmp + x;
+        int32x4_t sum0 = vdupq_n_s32(CONTRIB_ROUND);
+        int32x4_t sum1 = sum0;
+        uint16x4_t out0, out1;
+
+        for (j = 0; j < n; ++j, pp += kn) {
+            uint16x8_t px = vmovl_u8(vld1_u8(pp));
+
+            sum0 = vmlaq_n_s32(sum0, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(px))),
+                               cbp[j].weight);
+            sum1 = vmlaq_n_s32(sum1, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(px))),
+                               cbp[j].weight);
+        }
+        sum0 = vminq_s32(vmaxq_s32(vshrq_n_s32(sum0, CONTRIB_SHIFT), zero), max_out);
+        sum1 = vminq_s32(vmaxq_s32(vshrq_n_s32(sum1, CONTRIB_SHIFT), zero), max_out);
+        out0 = vqmovun_s32(sum0);
+        out1 = vqmovun_s32(sum1);
+        if (sizeofPixelOut == 1)
+            vst1_u8((byte *)dst + x, vqmovn_u16(vcombine_u16(out0, out1)));
+        else
+            vst1q_u16((bits16 *)dst + x, vcombine_u16(out0, out1));
+    }
+    return x;
+}
+#endif /* ISCALE_NEON */
+
+/* Do as much of a vertical zoom as the SIMD kernels can, returning the
+ * number of samples done.  The caller does the rest. */
+static int
+zoom_y_simd(void /*PixelOut */ * gs_restrict dst,
+            const byte * gs_restrict tmp, int skip, int WidthOut, int Stride,
+            int Colors, const CLIST * gs_restrict contrib, const CONTRIB * gs_restrict items,
+            int sizeofPixelOut, int maxval)
+{
+#ifdef ISCALE_SIMD
+    int kn = Stride * Colors;
+    int width = WidthOut * Colors;
+    const CONTRIB *gs_restrict cbp = items + contrib->index;
+    byte *gs_restrict d = (byte *)dst + skip * Colors * sizeofPixelOut;
+    int done = 0;
+
+#ifdef DEBUG
+    if (gs_debug_c('W'))
+        return 0;
+#endif
+    tmp += contrib->first_pixel + skip * Colors;
+#ifdef ISCALE_AVX2
+    if (zoom_y_use_avx2())
+        done = zoom_y_AVX2(d, tmp, width, kn, contrib->n, cbp,
+                           sizeofPixelOut, maxval);
+#endif
+#ifdef ISCALE_SSE2
+    done += zoom_y_SSE2(d + done * sizeofPixelOut, tmp + done, width - done,
+                        kn, contrib->n, cbp, sizeofPixelOut, maxval);
+#else
+    done = zoom_y_NEON(d, tmp, width, kn, contrib->n, cbp,
+                       sizeofPixelOut, maxval);
+#endif
+    return done;
+#else
+    return 0;
+#endif
+}
+
 /*
  * Apply filter to zoom vertically from tmp to dst.
  * This is simpler because we can treat all columns identically
@@ -591,6 +1045,16 @@ static void zoom_y1(void /*PixelOut */ * gs_restrict dst,
                  const byte * gs_restrict tmp, int skip, int WidthOut, int Stride,
                  int Colors, const CLIST * gs_restrict contrib, const CONTRIB * gs_restrict items)
 {
+    int done = zoom_y_simd(dst, tmp, skip, WidthOut, Stride, Colors,
+                           contrib, items, 1, 0xff);
+
+    if (done != 0) {
+        /* Finish off the rest as one long row of single samples. */
+        skip = skip * Colors + done;
+        WidthOut = WidthOut * Colors - done;
+        Stride *= Colors;
+        Colors = 1;
+    }
     switch(contrib->n) {
         case 4:
             zoom_y1_4(dst, tmp, skip, WidthOut, Stride, Colors, contrib, items);
@@ -712,6 +1176,15 @@ zoom_y2(void /*PixelOut */ * gs_restrict dst,
        const byte * gs_restrict tmp, int skip, int WidthOut, int Stride,
        int Colors, const CLIST * gs_restrict contrib, const CONTRIB * gs_restrict items)
 {
+    int done = zoom_y_simd(dst, tmp, skip, WidthOut, Stride, Colors,
+                           contrib, items, 2, 0xffff);
+
+    if (done != 0) {
+        skip = skip * Colors + done;
+        WidthOut = WidthOut * Colors - done;
+        Stride *= Colors;
+        Colors = 1;
+    }
     switch (contrib->n) {
         case 4:
             zoom_y2_4(dst, tmp, skip, WidthOut, Stride, Colors, contrib, items);
@@ -834,6 +1307,15 @@ zoom_y2_frac(void /*PixelOut */ * gs_restrict dst,
              const byte * gs_restrict tmp, int skip, int WidthOut, int Stride,
             int Colors, const CLIST * gs_restrict contrib, const CONTRIB * gs_restrict items)
 {
+    int done = zoom_y_simd(dst, tmp, skip, WidthOut, Stride, Colors,
+                           contrib, items, 2, frac_1);
+
+    if (done != 0) {
+        skip = skip * Colors + done;
+        WidthOut = WidthOut * Colors - done;
+        Stride *= Colors;
+        Colors = 1;
+    }
     switch (contrib->n) {
         case 4:
             zoom_y2_frac_4(dst, tmp, skip, WidthOut, Stride, Colors, contrib, items);
@@ -903,6 +1385,7 @@ s_IScale_set_defaults(stream_state * st)
     ss->tmp = 0;
     ss->contrib = 0;
     ss->items = 0;
+    ss->pairs = 0;
 }
 
 typedef struct filter_defn_s {
@@ -925,6 +1408,9 @@ do_init(stream_state        *st,
     int limited_HeightOut = (ss->params.HeightOut + abs_interp_limit - 1) / abs_interp_limit;
     int limited_EntireWidthOut = (ss->params.EntireWidthOut + abs_interp_limit - 1) / abs_interp_limit;
     int limited_EntireHeightOut = (ss->params.EntireHeightOut + abs_interp_limit - 1) / abs_interp_limit;
+    int items_count = horiz->contrib_pixels((double)limited_EntireWidthOut /
+                                            ss->params.EntireWidthIn) *
+                      limited_WidthOut;
 
     ss->sizeofPixelIn = ss->params.BitsPerComponentIn / 8;
     ss->sizeofPixelOut = ss->params.BitsPerComponentOut / 8;
@@ -954,16 +1440,13 @@ do_init(stream_state        *st,
                                                 sizeof(CLIST),
                                                 "image_scale contrib");
     ss->items = (CONTRIB *)
-                    gs_alloc_byte_array(mem,
-                                        (horiz->contrib_pixels(
-                                            (double)limited_EntireWidthOut /
-                                            ss->params.EntireWidthIn) *
-                                            limited_WidthOut),
+                    gs_alloc_byte_array(mem, items_count,
                                          sizeof(CONTRIB),
                                          "image_scale contrib[*]");
     ss->dst_items = (CONTRIB *) gs_alloc_byte_array(mem,
                                                     ss->max_support*2,
                                                     sizeof(CONTRIB), "image_scale contrib_dst[*]");
+    ss->pairs = 0;
     /* Allocate buffers for 1 row of source and destination. */
     ss->dst = 
         gs_alloc_byte_array(mem, limited_WidthOut * ss->params.spp_interp,
@@ -995,6 +1478,18 @@ do_init(stream_state        *st,
                       limited_WidthOut, ss->params.WidthIn, ss->params.WidthIn,
                       ss->params.spp_interp, 255. / ss->params.MaxValueIn,
                       horiz->filter_width, horiz->filter, horiz->min_scale);
+#ifdef ISCALE_SSE2
+    /* The SSE2 horizontal zooms take their weights in pairs. If there is
+     * no memory for them, or a weight won't fit, the scalar code is used. */
+    if (ss->sizeofPixelIn == 1 &&
+        (ss->params.spp_interp == 3 || ss->params.spp_interp == 4)
+#ifdef DEBUG
+        && !gs_debug_c('W')
+#endif
+        )
+        ss->pairs = calculate_pairs(mem, ss->contrib, ss->items,
+                                    limited_WidthOut, items_count);
+#endif
 
     /* Prepare the weights for the first output row. */
     calculate_dst_contrib(ss, 0);
@@ -1008,9 +1503,21 @@ do_init(stream_state        *st,
                 break;
             case 3:
                 ss->zoom_x = zoom_x1_3;
+#if defined(ISCALE_SSE2)
+                if (ss->pairs)
+                    ss->zoom_x = zoom_x1_3_SSE2;
+#elif defined(ISCALE_NEON)
+                ss->zoom_x = zoom_x1_3_NEON;
+#endif
                 break;
             case 4:
                 ss->zoom_x = zoom_x1_4;
+#if defined(ISCALE_SSE2)
+                if (ss->pairs)
+                    ss->zoom_x = zoom_x1_4_SSE2;
+#elif defined(ISCALE_NEON)
+                ss->zoom_x = zoom_x1_4_NEON;
+#endif
                 break;
             default:
                 ss->zoom_x = zoom_x1;
@@ -1166,7 +1673,7 @@ s_IScale_process(stream_state * st, stream_cursor_read * pr,
                        limited_LeftMarginOut, /* Line skip */
                        limited_PatchWidthOut, /* How many pixels to produce */
                        ss->params.spp_interp, /* Color count */
-                       ss->contrib, ss->items);
+                       ss->contrib, ss->items, ss->pairs);
             pr->ptr += rcount;
             ++(ss->src_y);
             goto top;
@@ -1193,6 +1700,8 @@ s_IScale_release(stream_state * st)
     ss->dst = 0;
     gs_free_object(mem, ss->items, "image_scale contrib[*]");
     ss->items = 0;
+    gs_free_object(mem, ss->pairs, "image_scale pairs");
+    ss->pairs = 0;
     gs_free_object(mem, ss->dst_items, "image_scale contrib_dst[*]");
     ss->dst_items = 0;
     gs_free_object(mem, ss->contrib, "image_scale contrib");
@@ -155,6 +155,8 @@ int ttfInterpreter__obtain(ttfMemory *mem, ttfInterpreter **ptti)
     tti->usage_size = 0;
     tti->ttf_memory = mem;
     tti->lock = 1;
+    memset(tti->prep_memo, 0, sizeof(tti->prep_memo));
+    tti->prep_memo_next = 0;
     tti->exec = mem->alloc_struct(mem, (const ttfMemoryDescriptor *)&st_TExecution_Context, "ttfInterpreter__obtain");
     if (!tti->exec) {
         mem->free(mem, tti, "ttfInterpreter__obtain");
@@ -169,9 +171,12 @@ void ttfInterpreter__release(ttfInterpreter **ptti)
 {
     ttfInterpreter *tti = *ptti;
     ttfMemory *mem = tti->ttf_memory;
+    int i;
 
     if(--tti->lock)
         return;
+    for (i = 0; i < TTF_PREP_MEMO_SIZE; i++)
+        mem->free(mem, tti->prep_memo[i], "ttfInterpreter__release");
     mem->free(mem, tti->usage, "ttfInterpreter__release");
     mem->free(mem, tti->exec, "ttfInterpreter__release");
     mem->free(mem, *ptti, "ttfInterpreter__release");
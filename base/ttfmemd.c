@@ -142,6 +142,28 @@ static RELOC_PTRS_WITH(ttfFont_reloc_ptrs, ttfFont *mptr)
     DISCARD(mptr);
 RELOC_PTRS_END
 
-gs_public_st_ptrs3(st_ttfInterpreter, ttfInterpreter, "ttfInterpreter",
-    st_ttfInterpreter_enum_ptrs, st_ttfInterpreter_reloc_ptrs,
-    exec, usage, ttf_memory);
+gs_public_st_composite(st_ttfInterpreter, ttfInterpreter,
+    "ttfInterpreter", ttfInterpreter_enum_ptrs, ttfInterpreter_reloc_ptrs);
+
+static
+ENUM_PTRS_WITH(ttfInterpreter_enum_ptrs, ttfInterpreter *mptr)
+    if (index - 3 < TTF_PREP_MEMO_SIZE)
+        ENUM_RETURN(mptr->prep_memo[index - 3]);
+    return 0;
+    ENUM_PTR(0, ttfInterpreter, exec);
+    ENUM_PTR(1, ttfInterpreter, usage);
+    ENUM_PTR(2, ttfInterpreter, ttf_memory);
+ENUM_PTRS_END
+
+static RELOC_PTRS_WITH(ttfInterpreter_reloc_ptrs, ttfInterpreter *mptr)
+{
+    int i;
+
+    RELOC_PTR(ttfInterpreter, exec);
+    RELOC_PTR(ttfInterpreter, usage);
+    RELOC_PTR(ttfInterpreter, ttf_memory);
+    for (i = 0; i < TTF_PREP_MEMO_SIZE; i++)
+        RELOC_PTR(ttfInterpreter, prep_memo[i]);
+    DISCARD(mptr);
+}
+RELOC_PTRS_END
@@ -64,6 +64,11 @@ struct ttfMemory_s {
 
 typedef struct ttfSubGlyphUsage_s ttfSubGlyphUsage;
 
+/* The results of a 'prep' program run, see Instance_Reset. */
+typedef struct ttfPrepMemo_s ttfPrepMemo;
+
+#define TTF_PREP_MEMO_SIZE 8
+
 /* Define a capsule for the TT interpreter. */
 struct ttfInterpreter_s {
     TExecution_Context *exec;
@@ -72,6 +77,8 @@ struct ttfInterpreter_s {
     int usage_top;
     int lock;
     ttfMemory *ttf_memory;
+    ttfPrepMemo *prep_memo[TTF_PREP_MEMO_SIZE]; /* Shared by all fonts, keyed with nFontId. */
+    int prep_memo_next;
 };
 
 /* Define TT interpreter return codes. */
@@ -132,6 +139,7 @@ struct ttfFont_s {
     unsigned int nIndexToLocFormat;
     bool    patented;
     bool    design_grid;
+    unsigned long nFontId; /* Identifies the font data for the prep memo, 0 = don't memoize. */
     TFace *face;
     TInstance *inst;
     TExecution_Context  *exec;
@@ -702,6 +702,174 @@ static int free_aux(ttfMemory *mem, void *ptr)
     return error;
   }
 
+/*******************************************************************
+ *
+ *  Prep memo
+ *
+ *  The cvt program result depends on the font and the instance
+ *  metrics only, so it is kept in a few records shared by all
+ *  instances of the interpreter.  Resetting another instance of
+ *  the same font to the same size restores the record instead of
+ *  running the program again.
+ *
+ ******************************************************************/
+
+  struct  ttfPrepMemo_s
+  {
+    unsigned long   nFontId;
+    TT_F26Dot6      pointSize;
+    Long            x_scale1, x_scale2;
+    Long            y_scale1, y_scale2;
+
+    TIns_Metrics    metrics;
+    TGraphicsState  GS;
+    TT_F26Dot6      period, phase, threshold;
+    Int             cvtSize, storeSize, n_twilight;
+    Int             numFDefs, numIDefs, countIDefs;
+    Byte            IDefPtr[256];
+    /* Followed with the cvt, the storage, the twilight zone */
+    /* and the function and instruction definitions.         */
+  };
+
+  static Long*  Prep_Memo_Longs( ttfPrepMemo*  memo )
+  {
+    return (Long*)(memo + 1);
+  }
+
+  static TT_F26Dot6*  Prep_Memo_Twilight( ttfPrepMemo*  memo )
+  {
+    return (TT_F26Dot6*)(Prep_Memo_Longs( memo ) +
+                         memo->cvtSize + memo->storeSize);
+  }
+
+  static TDefRecord*  Prep_Memo_Defs( ttfPrepMemo*  memo )
+  {
+    return (TDefRecord*)(Prep_Memo_Twilight( memo ) + 4 * memo->n_twilight);
+  }
+
+  static ttfPrepMemo*  Find_Prep_Memo( PExecution_Context  exec,
+                                       PInstance           ins )
+  {
+    ttfInterpreter*  tti = ins->face->font->tti;
+    unsigned long    id  = ins->face->font->nFontId;
+    Int              i;
+
+    if ( id == 0 )
+      return NULL;
+
+    for ( i = 0; i < TTF_PREP_MEMO_SIZE; i++ )
+    {
+      ttfPrepMemo*  memo = tti->prep_memo[i];
+
+      if ( memo != NULL && memo->nFontId == id &&
+           memo->pointSize == ins->metrics.pointSize &&
+           memo->x_scale1 == ins->metrics.x_scale1 &&
+           memo->x_scale2 == ins->metrics.x_scale2 &&
+           memo->y_scale1 == ins->metrics.y_scale1 &&
+           memo->y_scale2 == ins->metrics.y_scale2 &&
+           memo->cvtSize == exec->cvtSize &&
+           memo->storeSize == exec->storeSize &&
+           memo->numFDefs == exec->numFDefs &&
+           memo->numIDefs == exec->numIDefs &&
+           memo->n_twilight <= exec->twilight.n_points )
+        return memo;
+    }
+    return NULL;
+  }
+
+  static void  Store_Prep_Memo( PExecution_Context  exec,
+                                PInstance           ins )
+  {
+    ttfInterpreter*  tti = ins->face->font->tti;
+    ttfMemory*       mem = tti->ttf_memory;
+    Int              n_twilight = ins->face->maxProfile.maxTwilightPoints;
+    ttfPrepMemo*     memo;
+    TT_F26Dot6*      tw;
+    TDefRecord*      defs;
+
+    if ( ins->face->font->nFontId == 0 )
+      return;
+    if ( n_twilight > exec->twilight.n_points )
+      n_twilight = exec->twilight.n_points;
+
+    memo = mem->alloc_bytes( mem, sizeof(ttfPrepMemo) +
+                   (exec->cvtSize + exec->storeSize) * sizeof(Long) +
+                   4 * n_twilight * sizeof(TT_F26Dot6) +
+                   (exec->numFDefs + exec->numIDefs) * sizeof(TDefRecord),
+                   "Store_Prep_Memo" );
+    if ( memo == NULL )
+      return; /* Not an error, the program will be run again. */
+
+    memo->nFontId    = ins->face->font->nFontId;
+    memo->pointSize  = ins->metrics.pointSize;
+    memo->x_scale1   = ins->metrics.x_scale1;
+    memo->x_scale2   = ins->metrics.x_scale2;
+    memo->y_scale1   = ins->metrics.y_scale1;
+    memo->y_scale2   = ins->metrics.y_scale2;
+    memo->metrics    = exec->metrics;
+    memo->GS         = exec->GS;
+    memo->period     = exec->period;
+    memo->phase      = exec->phase;
+    memo->threshold  = exec->threshold;
+    memo->cvtSize    = exec->cvtSize;
+    memo->storeSize  = exec->storeSize;
+    memo->n_twilight = n_twilight;
+    memo->numFDefs   = exec->numFDefs;
+    memo->numIDefs   = exec->numIDefs;
+    memo->countIDefs = exec->countIDefs;
+    memcpy( memo->IDefPtr, exec->IDefPtr, sizeof(memo->IDefPtr) );
+
+    memcpy( Prep_Memo_Longs( memo ), exec->cvt,
+            exec->cvtSize * sizeof(Long) );
+    memcpy( Prep_Memo_Longs( memo ) + exec->cvtSize, exec->storage,
+            exec->storeSize * sizeof(Long) );
+
+    tw = Prep_Memo_Twilight( memo );
+    memcpy( tw,                  exec->twilight.org_x, n_twilight * sizeof(TT_F26Dot6) );
+    memcpy( tw + n_twilight,     exec->twilight.org_y, n_twilight * sizeof(TT_F26Dot6) );
+    memcpy( tw + 2 * n_twilight, exec->twilight.cur_x, n_twilight * sizeof(TT_F26Dot6) );
+    memcpy( tw + 3 * n_twilight, exec->twilight.cur_y, n_twilight * sizeof(TT_F26Dot6) );
+
+    defs = Prep_Memo_Defs( memo );
+    memcpy( defs, exec->FDefs, exec->numFDefs * sizeof(TDefRecord) );
+    memcpy( defs + exec->numFDefs, exec->IDefs,
+            exec->numIDefs * sizeof(TDefRecord) );
+
+    mem->free( mem, tti->prep_memo[tti->prep_memo_next], "Store_Prep_Memo" );
+    tti->prep_memo[tti->prep_memo_next] = memo;
+    tti->prep_memo_next = (tti->prep_memo_next + 1) % TTF_PREP_MEMO_SIZE;
+  }
+
+  static void  Restore_Prep_Memo( PExecution_Context  exec,
+                                  ttfPrepMemo*        memo )
+  {
+    Int          n_twilight = memo->n_twilight;
+    TT_F26Dot6*  tw = Prep_Memo_Twilight( memo );
+    TDefRecord*  defs = Prep_Memo_Defs( memo );
+
+    exec->metrics    = memo->metrics;
+    exec->GS         = memo->GS;
+    exec->period     = memo->period;
+    exec->phase      = memo->phase;
+    exec->threshold  = memo->threshold;
+    exec->countIDefs = memo->countIDefs;
+    memcpy( exec->IDefPtr, memo->IDefPtr, sizeof(exec->IDefPtr) );
+
+    memcpy( exec->cvt, Prep_Memo_Longs( memo ),
+            memo->cvtSize * sizeof(Long) );
+    memcpy( exec->storage, Prep_Memo_Longs( memo ) + memo->cvtSize,
+            memo->storeSize * sizeof(Long) );
+
+    memcpy( exec->twilight.org_x, tw,                  n_twilight * sizeof(TT_F26Dot6) );
+    memcpy( exec->twilight.org_y, tw + n_twilight,     n_twilight * sizeof(TT_F26Dot6) );
+    memcpy( exec->twilight.cur_x, tw + 2 * n_twilight, n_twilight * sizeof(TT_F26Dot6) );
+    memcpy( exec->twilight.cur_y, tw + 3 * n_twilight, n_twilight * sizeof(TT_F26Dot6) );
+
+    memcpy( exec->FDefs, defs, memo->numFDefs * sizeof(TDefRecord) );
+    memcpy( exec->IDefs, defs + memo->numFDefs,
+            memo->numIDefs * sizeof(TDefRecord) );
+  }
+
 /*******************************************************************
  *
  *  Function    : Instance_Reset
@@ -722,6 +890,7 @@ static int free_aux(ttfMemory *mem, void *ptr)
     Int       i;
     PFace     face;
     PExecution_Context exec;
+    ttfPrepMemo*       memo;
 
     if ( !ins )
       return TT_Err_Invalid_Instance_Handle;
@@ -797,7 +966,13 @@ static int free_aux(ttfMemory *mem, void *ptr)
       exec->twilight.cur_y[i] = 0;
     }
 
-    if ( face->cvtPgmSize > 0 )
+    if ( face->cvtPgmSize > 0 &&
+         ( memo = Find_Prep_Memo( exec, ins ) ) != NULL )
+    {
+      Restore_Prep_Memo( exec, memo );
+      error = TT_Err_Ok;
+    }
+    else if ( face->cvtPgmSize > 0 )
     {
       error = Goto_CodeRange( exec, TT_CodeRange_Cvt, 0 );
       if (error)
@@ -827,6 +1002,8 @@ static int free_aux(ttfMemory *mem, void *ptr)
 
       error = RunIns( exec );
       Unset_CodeRange(exec);
+      if ( !error )
+        Store_Prep_Memo( exec, ins );
     }
     else
       error = TT_Err_Ok;
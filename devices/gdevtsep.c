@@ -2471,6 +2471,10 @@ tiffsep_print_page(gx_device_printer * pdev, gp_file * file)
                                                      num_comp, factor, mfs, 8, dst_bpc,
                                                      tfdev->downscale.trap_w, tfdev->downscale.trap_h,
                                                      tfdev->downscale.trap_order);
+            if (code < 0)
+                goto cleanup;
+            /* Error diffuse the separations in parallel */
+            code = gx_downscaler_set_threads(&ds, pdev->num_render_threads_requested);
             if (code < 0)
                 goto cleanup;
             byte_width = (width * dst_bpc + 7)>>3;
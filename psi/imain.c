@@ -1218,6 +1218,8 @@ gs_main_finit(gs_main_instance * minst, int exit_status, int code)
     i_ctx_p = minst->i_ctx_p;		/* get current interp context */
     if (gs_debug_c(':')) {
         print_resource_usage(minst, &gs_imemory, "Final");
+        if (minst->heap->gs_lib_ctx->font_dir != NULL)
+            gs_print_cachestats(minst->heap->gs_lib_ctx->font_dir, minst->heap);
         dmprintf1(minst->heap, "%% Exiting instance 0x%p\n", minst);
     }
     /* Do the equivalent of a restore "past the bottom". */
@@ -60,6 +60,7 @@ free_code_map(gx_code_map_t * pcmap, gs_memory_t * mem)
         }
         gs_free_object(mem, pcmap->lookup, "free_code_map(map)");
     }
+    gs_free_object(mem, pcmap->index, "free_code_map(index)");
 }
 
 /* Convert code ranges to internal form. */
@@ -455,6 +456,9 @@ zbuildcmap(i_ctx_t *i_ctx_p)
         goto fail;
     if ((code = acquire_code_map(&pcmap->notdef, &rnotdefs, pcmap, imemory)) < 0)
         goto fail;
+    if ((code = gs_cmap_adobe1_index_code_map(&pcmap->def, imemory)) < 0 ||
+        (code = gs_cmap_adobe1_index_code_map(&pcmap->notdef, imemory)) < 0)
+        goto fail;
     if (!bytes_compare(pcmap->CIDSystemInfo->Registry.data, pcmap->CIDSystemInfo->Registry.size,
                     (const byte *)"Artifex", 7) &&
         !bytes_compare(pcmap->CIDSystemInfo->Ordering.data, pcmap->CIDSystemInfo->Ordering.size,
@@ -463,6 +463,52 @@ zgetscanconverter(i_ctx_t *i_ctx_p)
     make_int(op, gs_getscanconverter(imemory));
     return 0;
 }
+
+/* <int> .setscanconverterthreads - */
+static int
+zsetscanconverterthreads(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    check_type(*op, t_integer);
+    gs_setscanconverterthreads(igs, op->value.intval);
+    pop(1);
+    return 0;
+}
+
+/* - .getscanconverterthreads <int> */
+static int
+zgetscanconverterthreads(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    push(1);
+    make_int(op, gs_getscanconverterthreads(imemory));
+    return 0;
+}
+
+/* <int> .setimagethreads - */
+static int
+zsetimagethreads(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    check_type(*op, t_integer);
+    gs_setimagethreads(igs, op->value.intval);
+    pop(1);
+    return 0;
+}
+
+/* - .getimagethreads <int> */
+static int
+zgetimagethreads(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    push(1);
+    make_int(op, gs_getimagethreads(imemory));
+    return 0;
+}
 /* ------ Initialization procedure ------ */
 
 const op_def zmisc_a_op_defs[] =
@@ -488,5 +534,9 @@ const op_def zmisc_b_op_defs[] =
     {"0.getCPSImode", zgetCPSImode},
     {"1.setscanconverter", zsetscanconverter},
     {"0.getscanconverter", zgetscanconverter},
+    {"1.setscanconverterthreads", zsetscanconverterthreads},
+    {"0.getscanconverterthreads", zgetscanconverterthreads},
+    {"1.setimagethreads", zsetimagethreads},
+    {"0.getimagethreads", zgetimagethreads},
     op_def_end(0)
 };
@@ -298,7 +298,7 @@ zbegintransparencymaskgroup(i_ctx_t *i_ctx_p)
     gs_transparency_mask_params_t params;
     ref *pparam;
     gs_rect bbox;
-    int code;
+    int code, cache_key;
     static const char *const subtype_names[] = {
         GS_TRANSPARENCY_MASK_SUBTYPE_NAMES, 0
     };
@@ -321,6 +321,14 @@ zbegintransparencymaskgroup(i_ctx_t *i_ctx_p)
     if ((code = dict_floats_param(imemory, dop, "GrayBackground",
                     1, &params.GrayBackground, NULL)) < 0)
         return code;
+    /* Masks with the same (non-zero) CacheKey have the same content */
+    if ((code = dict_int_param(dop, "CacheKey", 0, max_int, 0, &cache_key)) < 0)
+        return code;
+    params.cache_id = cache_key;
+    /* The content is drawn in the state captured with the mask, if any */
+    if (cache_key != 0 && dict_find_string(dop, "GroupGState", &pparam) > 0 &&
+        r_has_stype(pparam, imemory, st_igstate_obj))
+        params.cache_gstate = igstate_ptr(pparam);
     if (dict_find_string(dop, "TransferFunction", &pparam) > 0) {
         gs_function_t *pfn = ref_function(pparam);
 
@@ -388,6 +396,21 @@ zbegintransparencymaskimage(i_ctx_t *i_ctx_p)
     return code;
 }
 
+/* - .transparencymaskcached <bool> */
+/* After .begintransparencymaskgroup, true if the mask will be taken from the
+   device's cache and there is no need to draw its content. */
+static int
+ztransparencymaskcached(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+    gx_device *dev = gs_currentdevice(igs);
+
+    push(1);
+    make_bool(op, dev_proc(dev, dev_spec_op)(dev, gxdso_pdf14_smask_cached,
+                                             NULL, 0) > 0);
+    return 0;
+}
+
 /* Implement the TransferFunction using a Function. */
 static int
 tf_using_function(double in_val, float *out, void *proc_data)
@@ -693,6 +716,7 @@ const op_def ztrans2_op_defs[] = {
     {"5.begintransparencymaskgroup", zbegintransparencymaskgroup},
     {"1.begintransparencymaskimage", zbegintransparencymaskimage},
     {"1.endtransparencymask", zendtransparencymask},
+    {"0.transparencymaskcached", ztransparencymaskcached},
     {"1.image3x", zimage3x},
     {"1.pushpdf14devicefilter", zpushpdf14devicefilter},
     {"0.poppdf14devicefilter", zpoppdf14devicefilter},
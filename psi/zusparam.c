@@ -166,6 +166,38 @@ current_CurFontCache(i_ctx_t *i_ctx_p)
     return cstat[0];
 }
 static long
+current_FontCacheLookups(i_ctx_t *i_ctx_p)
+{
+    gs_font_cache_stats stats;
+
+    gs_cachestats(ifont_dir, &stats);
+    return stats.lookups;
+}
+static long
+current_FontCacheHits(i_ctx_t *i_ctx_p)
+{
+    gs_font_cache_stats stats;
+
+    gs_cachestats(ifont_dir, &stats);
+    return stats.hits;
+}
+static long
+current_FontCacheMisses(i_ctx_t *i_ctx_p)
+{
+    gs_font_cache_stats stats;
+
+    gs_cachestats(ifont_dir, &stats);
+    return stats.misses;
+}
+static long
+current_FontCacheEvictions(i_ctx_t *i_ctx_p)
+{
+    gs_font_cache_stats stats;
+
+    gs_cachestats(ifont_dir, &stats);
+    return stats.evictions;
+}
+static long
 current_MaxGlobalVM(i_ctx_t *i_ctx_p)
 {
     gs_memory_gc_status_t stat;
@@ -212,7 +244,11 @@ static const long_param_def_t system_long_params[] =
     {"PageCount", min_long, max_long, current_PageCount, NULL},
 
     /* Extensions */
-    {"MaxGlobalVM", 0, max_long, current_MaxGlobalVM, set_MaxGlobalVM}
+    {"MaxGlobalVM", 0, max_long, current_MaxGlobalVM, set_MaxGlobalVM},
+    {"FontCacheLookups", 0, max_long, current_FontCacheLookups, NULL},
+    {"FontCacheHits", 0, max_long, current_FontCacheHits, NULL},
+    {"FontCacheMisses", 0, max_long, current_FontCacheMisses, NULL},
+    {"FontCacheEvictions", 0, max_long, current_FontCacheEvictions, NULL}
 };
 
 /* Boolean values */
@@ -471,6 +507,17 @@ set_GridFitTT(i_ctx_t *i_ctx_p, long val)
     gs_setgridfittt(ifont_dir, (uint)val);
     return 0;
 }
+static long
+current_SubpixelPhases(i_ctx_t *i_ctx_p)
+{
+    return gs_currentsubpixelphases(ifont_dir);
+}
+static int
+set_SubpixelPhases(i_ctx_t *i_ctx_p, long val)
+{
+    gs_setsubpixelphases(ifont_dir, (uint)val);
+    return 0;
+}
 
 #undef ifont_dir
 
@@ -598,7 +645,9 @@ static const long_param_def_t user_long_params[] =
     {"AlignToPixels", 0, 1,
      current_AlignToPixels, set_AlignToPixels},
     {"GridFitTT", 0, 3,
-     current_GridFitTT, set_GridFitTT}
+     current_GridFitTT, set_GridFitTT},
+    {"SubpixelPhases", 0, 16,
+     current_SubpixelPhases, set_SubpixelPhases}
 };
 
 /* Note that string objects that are maintained as user params must be